@@ -0,0 +1,73 @@
+#ifndef _SPL_BITS_
+#define _SPL_BITS_
+
+///
+/// \file  bits.h
+/// \brief Операции над упакованными словами: подсчет бит и счетчики в байтах.
+///
+/// Используются при сравнении кадров маски с шаблонами ЧОТ.
+/// Все функции встраиваемые и не требуют внешних библиотек.
+///
+
+#include "spl_types.h"
+
+#if defined(_MSC_VER) && defined(_M_X64) && defined(__AVX2__)
+#include <intrin.h>
+#endif
+
+NAMESPACE_SPL_BEGIN;
+
+/// Количество единичных бит в слове без специальных инструкций (SWAR).
+inline unsigned popcount_swar(mask_word_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return unsigned((x * 0x0101010101010101ULL) >> 56);
+}
+
+/// Количество единичных бит в слове.
+/// Инструкция POPCNT есть не на всех процессорах x64, а __popcnt64 в MSVC не проверяет этого:
+///  она используется, только если сборка и так требует AVX2 (/arch:AVX2), иначе - SWAR.
+/// __builtin_popcountll в GCC генерирует POPCNT только при -mpopcnt (или -march с ней).
+inline unsigned popcount_word(mask_word_t x) {
+#if defined(_MSC_VER) && defined(_M_X64) && defined(__AVX2__)
+    return unsigned(__popcnt64(x));
+#elif defined(__GNUC__)
+    return unsigned(__builtin_popcountll(x));
+#else
+    return popcount_swar(x);
+#endif
+}
+
+///
+/// Счетчики в байтах (SWAR): слово содержит 8 независимых счетчиков по модулю 256,
+///  переносы между байтами не распространяются.
+///
+
+const mask_word_t BYTE_LOW7 = 0x7F7F7F7F7F7F7F7FULL;
+const mask_word_t BYTE_HIGH = 0x8080808080808080ULL;
+
+/// Побайтовое сложение слов.
+inline mask_word_t bytes_add(mask_word_t a, mask_word_t b) {
+    return ((a & BYTE_LOW7) + (b & BYTE_LOW7)) ^ ((a ^ b) & BYTE_HIGH);
+}
+
+/// Побайтовое вычитание слов.
+inline mask_word_t bytes_sub(mask_word_t a, mask_word_t b) {
+    return ((a | BYTE_HIGH) - (b & BYTE_LOW7)) ^ ((a ^ ~b) & BYTE_HIGH);
+}
+
+//@{
+/// Побайтовое сложение и вычитание \a n слов: r = a +- b.
+inline void bytes_add_n(mask_word_t *r, const mask_word_t *a, const mask_word_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) r[i] = bytes_add(a[i], b[i]);
+}
+
+inline void bytes_sub_n(mask_word_t *r, const mask_word_t *a, const mask_word_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) r[i] = bytes_sub(a[i], b[i]);
+}
+//@}
+
+NAMESPACE_SPL_END;
+
+#endif//_SPL_BITS_
@@ -32,6 +32,11 @@ template<typename T>
 T *spl_alloc(size_t siz) {
 	return (T*) spl_alloc_low(siz * sizeof(T));
 }
+
+/// Free memory of spl_alloc() owned by std::unique_ptr.
+struct spl_deleter {
+	void operator()(void *addr) const { spl_free(addr); }
+};
 //@}
 
 NAMESPACE_SPL_END;
@@ -12,6 +12,7 @@ const signal_params_t signal_params_t::DEFAULT = { 12000 };
 const scale_params_t scale_params_t::DEFAULT = { 256, scale_form_t::model, {0, 50}, {0, 4000} };
 const spectrum_params_t spectrum_params_t::DEFAULT = { 0.001 };
 const mask_params_t mask_params_t::DEFAULT = { 0.001, 1, 1, true };
+const temp_mask_params_t temp_mask_params_t::DEFAULT = { 0.020, 0.1 };
 const pitch_params_t pitch_params_t::DEFAULT = { 2, 75, 400 };
 const vocal_params_t vocal_params_t::DEFAULT = { 0.030, 0.030 };
 const spl_params_t spl_params_t::DEFAULT = {
@@ -19,6 +20,7 @@ const spl_params_t spl_params_t::DEFAULT = {
     scale_params_t::DEFAULT,
     spectrum_params_t::DEFAULT,
     mask_params_t::DEFAULT,
+    temp_mask_params_t::DEFAULT,
     pitch_params_t::DEFAULT,
     vocal_params_t::DEFAULT
 };
@@ -178,6 +180,8 @@ field_config_t field_configurations[] = {
     FIELD("scale_num_channels", scale.K),
     FIELD("signal_sampling_freq", signal.F),
     FIELD("spectrum_ksi", spectrum.ksi),
+    FIELD("temp_mask_rho", temp_mask.rho),
+    FIELD("temp_mask_tau", temp_mask.tau),
     FIELD("vocal_min_interval", vocal.minV),
     FIELD("vocal_min_nonvocal", vocal.minNV),
 };
@@ -63,6 +63,18 @@ struct mask_params_t {
     static const mask_params_t DEFAULT;
 };
 
+/// Параметры последовательной (временной) маскировки (\ref temp_mask_calculator).
+struct temp_mask_params_t {
+
+    /// Постоянная времени спада маскирующего порога (в секундах).
+    double tau;
+
+    /// Вес маскирующего порога относительно маскера.
+    double rho;
+
+    static const temp_mask_params_t DEFAULT;
+};
+
 /// Параметры генерации шаблонов для выделения ЧОТ - частоты основного тона (см. \ref mask_templates).
 struct pitch_params_t {
 
@@ -95,6 +107,7 @@ struct spl_params_t {
     scale_params_t scale;
     spectrum_params_t spectrum;
     mask_params_t freq_mask;
+    temp_mask_params_t temp_mask;
     pitch_params_t pitch;
     vocal_params_t vocal;
 
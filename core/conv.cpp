@@ -8,63 +8,178 @@
 
 #include "conv.h"
 using spl::SPL_MEMORY_ALIGN;
+using spl::real_t;
 
 #include <fftw3.h>
 #include <math.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
 
 namespace {
 
+// Функции и типы FFTW нужной точности: fftw_* (double) или fftwf_* (float, SPL_FLOAT)
+#ifdef SPL_FLOAT
+#define FFTW(name) fftwf_##name
+#define SPL_FFTW_WISDOM_FILE "spl-fftwf-wisdom"
+#else
+#define FFTW(name) fftw_##name
 #define SPL_FFTW_WISDOM_FILE "spl-fftw-wisdom"
-fftw_plan plan_A, plan_BC, plan_abc;
-
-// Авто-инициализация
-struct my_init {
-  my_init() {
-    using spl::CONV_WIN_SIZ;
-    FILE *f;
-    
-    // try to open wisdom file:
-    f = fopen(SPL_FFTW_WISDOM_FILE, "r");
-    if(f) {
-     char wisdom[10000];
-     fread(wisdom, 1, 10000, f);
-     fftw_import_wisdom_from_string(wisdom);
-     fclose(f); 
-    }
+#endif
+
+using spl::conv_plan_mode_t;
+
+/// Вид преобразования.
+enum plan_kind_t {
+  plan_r2c, ///< прямое real-to-complex
+  plan_c2r, ///< обратное complex-to-real
+};
+
+/// Ключ плана: по нему планы ищутся в реестре.
+struct plan_key_t {
+  int n;            ///< размер преобразования
+  plan_kind_t kind; ///< вид преобразования
+  int howmany;      ///< количество преобразований в пакете
+  bool aligned;     ///< все массивы выровнены для SIMD
+
+  bool operator<(const plan_key_t& k) const {
+    if(n != k.n) return n < k.n;
+    if(kind != k.kind) return kind < k.kind;
+    if(howmany != k.howmany) return howmany < k.howmany;
+    return aligned < k.aligned;
+  }
+};
+
+///
+/// Реестр планов FFTW.
+///
+/// Планы создаются лениво - при первом обращении с данным ключом, 
+///  и живут до конца работы программы.
+/// Планировщик FFTW не потокобезопасен, поэтому все обращения к нему 
+///  выполняются под мьютексом реестра; 
+///  исполнение готовых планов (fftw_execute_*) потокобезопасно и блокировки не требует.
+///
+
+class plan_registry_t {
+public:
+  plan_registry_t(): mode(spl::conv_plan_measure), wisdom_file(SPL_FFTW_WISDOM_FILE), wisdom_loaded(false) {}
 
-	double *array = spl::conv_alloc<double>(CONV_WIN_SIZ * 4 + 2);
-	double *ri = array;
-    double *ii = ri + CONV_WIN_SIZ;
-    double *ro = ri + 2*CONV_WIN_SIZ;
-    double *io = ri + 3*CONV_WIN_SIZ;
-    
-    fftw_iodim dim, howmany;
-    dim.n = CONV_WIN_SIZ; dim.is = dim.os = 1;
-	howmany.n = 256; howmany.is = howmany.os = CONV_WIN_SIZ;
-
-    // generate wisdom:
-    plan_A = fftw_plan_guru_split_dft_r2c(1, &dim, 0, 0, ri, ro, io, FFTW_MEASURE);
-    plan_BC = fftw_plan_guru_split_dft(1, &dim, 0, 0, ri, ii, ro, io, FFTW_MEASURE);
-	plan_abc = plan_BC;
-//    plan_abc = fftw_plan_guru_split_dft(1, &dim, 1, &howmany, ri, ii, ro, io, FFTW_ESTIMATE);
-
-    // try to save wisdom:
-	f = fopen(SPL_FFTW_WISDOM_FILE, "w");
-	if(f) {
-		fftw_export_wisdom(myputc, f);
-		fclose(f);
-	}
-	spl::conv_free(array);
+  ~plan_registry_t() {
+    for(auto& p: plans)
+      FFTW(destroy_plan)(p.second);
+  }
+
+  /// Получение плана по ключу (с созданием при необходимости).
+  FFTW(plan) get(const plan_key_t& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto p = plans.find(key);
+    if(p != plans.end())
+      return p->second;
+
+    load_wisdom();
+    FFTW(plan) plan = create(key);
+    if(plan == 0)
+      throw "Can't create FFT plan";
+    plans[key] = plan;
+    // ESTIMATE не порождает новой мудрости - сохранять нечего
+    if(mode != spl::conv_plan_estimate)
+      save_wisdom();
+    return plan;
+  }
+
+  void set_mode(conv_plan_mode_t m) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mode = m;
+  }
+
+  void set_wisdom_file(const char *file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    wisdom_file = file ? file : "";
+    wisdom_loaded = false;
   }
 
 private:
-	static void myputc(char x, void *f) {
-		putc(x, (FILE *)f);
-	}
+  std::mutex mutex;
+  std::map<plan_key_t, FFTW(plan)> plans;
+  conv_plan_mode_t mode;
+  std::string wisdom_file;
+  bool wisdom_loaded;
 
-} _my_init;
+  unsigned flags() const {
+    switch(mode) {
+    case spl::conv_plan_estimate: return FFTW_ESTIMATE;
+    case spl::conv_plan_patient:  return FFTW_PATIENT;
+    default:                      return FFTW_MEASURE;
+    }
+  }
+
+  void load_wisdom() {
+    if(wisdom_loaded || wisdom_file.empty()) return;
+    FFTW(import_wisdom_from_filename)(wisdom_file.c_str());
+    wisdom_loaded = true;
+  }
+
+  void save_wisdom() {
+    if(wisdom_file.empty()) return;
+    FFTW(export_wisdom_to_filename)(wisdom_file.c_str());
+  }
+
+  /// Создание плана.
+  /// Планирование (MEASURE, PATIENT) портит массивы, поэтому план строится 
+  ///  на собственных массивах в той же раскладке, что и у свертки, 
+  ///  а исполняется затем на массивах вызывающего (new-array execute).
+  FFTW(plan) create(const plan_key_t& key) {
+    const int n = key.n;
+    const int step = spl::conv_spec_step(n);
+
+    FFTW(iodim) dim, howmany;
+    dim.n = n; dim.is = dim.os = 1;
+    howmany.n = key.howmany;
+
+    unsigned f = flags();
+    if(!key.aligned)
+      f |= FFTW_UNALIGNED;
+
+    real_t *r = (real_t *) FFTW(malloc)(sizeof(real_t) * key.howmany * (n + 2 * step));
+    if(r == 0)
+      return 0;
+    real_t *X = r + key.howmany * n;
+
+    FFTW(plan) plan;
+    if(key.kind == plan_r2c) {
+      // r -> (X, X + step), пакет: шаг n на входе, 2*step на выходе
+      howmany.is = n; howmany.os = 2 * step;
+      plan = FFTW(plan_guru_split_dft_r2c)(1, &dim, 1, &howmany, r, X, X + step, f);
+    } else {
+      // (X, X + step) -> r, пакет: шаг 2*step на входе, n на выходе
+      howmany.is = 2 * step; howmany.os = n;
+      plan = FFTW(plan_guru_split_dft_c2r)(1, &dim, 1, &howmany, X, X + step, r, f);
+    }
+    FFTW(free)(r);
+    return plan;
+  }
+};
+
+plan_registry_t& registry() {
+  static plan_registry_t r;
+  return r;
+}
+
+/// Проверка выравнивания массивов, участвующих в преобразовании.
+inline bool is_aligned(const real_t *a, const real_t *b, const real_t *c) {
+  return FFTW(alignment_of)(const_cast<real_t*>(a)) == 0 
+      && FFTW(alignment_of)(const_cast<real_t*>(b)) == 0 
+      && FFTW(alignment_of)(const_cast<real_t*>(c)) == 0;
+}
+
+/// План одного (или пакета из howmany) преобразований размера n.
+inline FFTW(plan) get_plan(int n, plan_kind_t kind, int howmany, const real_t *a, const real_t *b, const real_t *c) {
+  plan_key_t key = { n, kind, howmany, is_aligned(a, b, c) };
+  return registry().get(key);
+}
 
 }
 
@@ -74,103 +189,221 @@ namespace spl {
 // операции с памятью
 //
 
+namespace {
+std::atomic<size_t> alloc_count(0);
+}
+
 void *conv_alloc_low(size_t N) {
-  return fftw_malloc(N);
+  alloc_count++;
+  return FFTW(malloc)(N);
 }
 
-void conv_free(void *x) {
-  fftw_free(x);
+size_t conv_alloc_count() {
+  return alloc_count;
 }
 
 //
-// некоторые комплексные операции
+// планы FFT
 //
 
-/// Умножение комплексных чисел.
-/// (Ar + iAi) * (Br + iBi) = ArBr - AiBi + i(ArBi + AiBr)
-/// допускает in-place умножение
-inline void complex_mul_split(
-    const double& Ar, const double& Ai,
-    const double& Br, const double& Bi,
-    double& ABr, double& ABi) 
-{
- double r = Ar * Br;
- double i = Ai * Bi;
- ABi = (Ar + Ai) * (Br + Bi) - r - i;
- ABr = r - i;
+void conv_set_plan_mode(conv_plan_mode_t mode) {
+  registry().set_mode(mode);
 }
 
-/// Вычисление модуля каждого элемента комплексного вектора.
-void complex_abs_split(size_t N, const double *Ar, const double *Ai, double *Am) {
- for(size_t i = N; i--; ) {
-  Am[i] = Ar[i] * Ar[i] + Ai[i] * Ai[i];
- }
+void conv_set_wisdom_file(const char *file) {
+  registry().set_wisdom_file(file);
 }
 
+void conv_free(void *x) {
+  FFTW(free)(x);
+}
 
 //
 // составные части быстрого вычисления двойной циклической свертки через FFT
 //
 
 /// Вычисление вектора A = FFT(a).
-void cconv_calc_A(const double *a, double *Ar, double *Ai) {
-  fftw_execute_split_dft_r2c(plan_A, const_cast<double*>(a), Ar, Ai);
-  // особенность библиотеки FFTW: из-за симметрии возвращает только половину A
-  // поэтому заполняем вторую половину:
-  for(int i = CONV_WIN_SIZ/2 + 1; i < CONV_WIN_SIZ; i++) {
-	  Ar[i] =  Ar[CONV_WIN_SIZ - i];
-	  Ai[i] = -Ai[CONV_WIN_SIZ - i];
-  }
+/// Особенность библиотеки FFTW: из-за симметрии возвращает только половину A - 
+///  ее и используем, вторая половина не нужна.
+void cconv_calc_A(const real_t *a, real_t *Ar, real_t *Ai, int n) {
+  FFTW(plan) plan = get_plan(n, plan_r2c, 1, a, Ar, Ai);
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(a), Ar, Ai);
+}
+
+void cconv_calc_A(const real_t *a, real_t *Ar, real_t *Ai, cconv_workspace& ws) {
+  FFTW(plan) plan = (FFTW(plan)) ws.plans().r2c(is_aligned(a, Ar, Ai));
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(a), Ar, Ai);
+}
+
+/// Вычисление векторов B = FFT(b), C = FFT(c).
+void cconv_calc_BC(const real_t *b, const real_t *c, real_t *B, real_t *C, int n) {
+  const int step = conv_spec_step(n);
+  FFTW(plan) plan = get_plan(n, plan_r2c, 1, b, B, B + step);
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(b), B, B + step);
+  plan = get_plan(n, plan_r2c, 1, c, C, C + step);
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(c), C, C + step);
 }
 
-/// Вычисление вектора (B,C) = FFT((b,c)).
-void cconv_calc_BC(const double *b, const double *c, double *B, double *C) {
-  fftw_execute_split_dft(plan_BC, const_cast<double*>(b), const_cast<double*>(c), B, C);
+void cconv_calc_BC(const real_t *b, const real_t *c, real_t *B, real_t *C, cconv_workspace& ws) {
+  const int step = conv_spec_step(ws.size());
+  FFTW(plan) plan = (FFTW(plan)) ws.plans().r2c(is_aligned(b, B, B + step));
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(b), B, B + step);
+  plan = (FFTW(plan)) ws.plans().r2c(is_aligned(c, C, C + step));
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(c), C, C + step);
 }
 
 /// Вычисление вектора ABC: (AB,AC) = A * (B,C).
 /// Необходимо для быстрого вычисления двойной циклической свертки (a * (b,c))
-void cconv_calc_ABC(
- const  double *Ar, const  double *Ai, 
- const  double *B,  const  double *C, 
- double *AB, double *AC) 
+/// Оба произведения считаются за один проход векторным ядром (см. conv_simd.cpp).
+inline void cconv_calc_ABC(
+ const  real_t *Ar, const  real_t *Ai, 
+ const  real_t *B,  const  real_t *C, 
+ real_t *AB, real_t *AC, int n) 
 {
-	for(int i = 0; i < CONV_WIN_SIZ; i++) {
-		complex_mul_split(Ar[i], Ai[i], B[i], C[i], AB[i], AC[i]);
-	}
+	complex_mul_split2(conv_spec_siz(n), Ar, Ai, B, C, AB, AC, conv_spec_step(n));
 }
 
 /// Вычисление вектора abc: (ab,ac) = IFFT((AB,AC)).
 /// Необходимо для быстрого вычисления двойной циклической свертки (a * (b,c))
-void cconv_calc_abc(const double *AB, const double *AC, double *ab, double *ac) {
-  // чтобы получить обратное DFT, re & im меняются местами (FFTW reference)
-  fftw_execute_split_dft(plan_abc, const_cast<double*>(AC), const_cast<double*>(AB), ac, ab);
+/// Внимание: complex-to-real преобразование FFTW портит входные массивы AB, AC.
+void cconv_calc_abc(real_t *AB, real_t *AC, real_t *ab, real_t *ac, cconv_workspace& ws) {
+  const int step = conv_spec_step(ws.size());
+  FFTW(plan) plan = (FFTW(plan)) ws.plans().c2r(is_aligned(AB, AB + step, ab));
+  FFTW(execute_split_dft_c2r)(plan, AB, AB + step, ab);
+  plan = (FFTW(plan)) ws.plans().c2r(is_aligned(AC, AC + step, ac));
+  FFTW(execute_split_dft_c2r)(plan, AC, AC + step, ac);
 }
 
 /// Нормализация коэффициентов фильтра.
-void cconv_normalize(double *x, size_t n) {
-  for(size_t j = 0; j < n; j++) 
-    x[j] /= CONV_WIN_SIZ;
+void cconv_normalize(real_t *x, size_t count, int n) {
+  for(size_t j = 0; j < count; j++) 
+    x[j] /= n;
+}
+
+/// Выбор размера циклической свертки.
+/// Стоимость блока - операции над ним: прямое FFT сигнала и 2K обратных FFT (по N log N),
+///  умножение K пар половин спектров (около 3N на пару) и перенос K полезных частей на выход (N).
+/// Количество блоков - длина сигнала, деленная на полезную часть блока (N - Ws + 1).
+/// Постоянных накладных расходов на блок нет: планы берутся из реестра при создании вычислителя,
+///  а копирование перекрытия уже учтено тем, что полезная часть короче блока.
+int cconv_choose_size(int Ws, size_t length, int K) {
+  int N = CONV_MIN_SIZ;
+  while(N < 2 * Ws) N *= 2;
+
+  int best = N;
+  double best_cost = 0;
+  for(; N <= CONV_MAX_SIZ; N *= 2) {
+    const double Os = N - Ws + 1;
+    const double blocks = length ? ceil(length / Os) : 1.0 / Os;
+    const double cost = blocks * ((1 + 2.0 * K) * N * log((double)N) / log(2.0) + 4.0 * K * N);
+    if(N == best || cost < best_cost) {
+      best = N;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
+//
+// планы и рабочая память свертки
+//
+
+cconv_plans::cconv_plans(int n_, int howmany_): n(n_), howmany(howmany_) {
+  // массивы из conv_alloc выровнены - эти планы нужны всегда
+  plan_key_t r2c = { n, plan_r2c, 1, true }, c2r = { n, plan_c2r, howmany, true };
+  _r2c[0] = _c2r[0] = 0;
+  _r2c[1] = registry().get(r2c);
+  _c2r[1] = registry().get(c2r);
+}
+
+void *cconv_plans::r2c(bool aligned) {
+  if(!_r2c[aligned]) {
+    plan_key_t key = { n, plan_r2c, 1, aligned };
+    _r2c[aligned] = registry().get(key);
+  }
+  return _r2c[aligned];
+}
+
+void *cconv_plans::c2r(bool aligned) {
+  if(!_c2r[aligned]) {
+    plan_key_t key = { n, plan_c2r, howmany, aligned };
+    _c2r[aligned] = registry().get(key);
+  }
+  return _c2r[aligned];
+}
+
+cconv_workspace::cconv_workspace(int n_): n(n_), _AB(0), _plans(n_) {
+  _AB = conv_alloc<real_t>(4 * conv_spec_step(n));
+  if(_AB == 0)
+    throw "Can't allocate memory for convolution workspace";
+}
+
+cconv_workspace::~cconv_workspace() {
+  conv_free(_AB);
 }
 
 /// Двойная циклическая свертка, рассчитанная по быстрому алгоритму.
 void cconv(
- const  double *Ar, const  double *Ai, 
- const  double *B,  const  double *C, 
- double *ab, double *ac) 
+ const  real_t *Ar, const  real_t *Ai, 
+ const  real_t *B,  const  real_t *C, 
+ real_t *ab, real_t *ac,
+ cconv_workspace& ws) 
 {
-  // 0. массивы и ссылки
-  double *array = conv_alloc<double>(2 * CONV_WIN_SIZ + 2);
-  double *ABCr = array;
-  double *ABCi = ABCr + CONV_WIN_SIZ;
+  // 0. ссылки на рабочую память
+  const int n = ws.size();
+  real_t *AB = ws.AB();
+  real_t *AC = ws.AC();
+
+  // 1. (AB,AC) = A .* (B,C)
+  cconv_calc_ABC(Ar, Ai, B, C, AB, AC, n);
 
-  // 1. ABC = A .* BC
-  cconv_calc_ABC(Ar, Ai, B, C, ABCr, ABCi);
+  // 2. (ab,ac) = ifft(AB,AC)
+  cconv_calc_abc(AB, AC, ab, ac, ws);
+}
+
+
+//
+// пакетная двойная циклическая свертка
+//
 
-  // 2. (ab,ac) = ifft(ABC)
-  cconv_calc_abc(ABCr, ABCi, ab, ac);
+// 2K обратных преобразований complex-to-real размера n:
+// сначала K половин спектров AB_k, затем K половин спектров AC_k
+// план принадлежит реестру и разделяется всеми объектами с тем же K
+cconv_batch::cconv_batch(int K_, int n_): 
+  K(K_), n(n_), step(conv_spec_step(n_)), _ABC(0), _ab(0), _ac(0), plans(n_, 2 * K_)
+{
+  _ABC = conv_alloc<real_t>(2 * K * (2 * step) + 2 * K * n);
+  if(_ABC == 0)
+    throw "Can't allocate memory for batch convolution";
+  _ab = _ABC + 2 * K * (2 * step);
+  _ac = _ab + K * n;
+}
+
+cconv_batch::~cconv_batch() {
+  conv_free(_ABC);
+}
+
+void cconv_batch::calc_A(const real_t *a, real_t *Ar, real_t *Ai) {
+  FFTW(plan) plan = (FFTW(plan)) plans.r2c(is_aligned(a, Ar, Ai));
+  FFTW(execute_split_dft_r2c)(plan, const_cast<real_t*>(a), Ar, Ai);
+}
+
+void cconv_batch::execute(
+ const  real_t *Ar, const  real_t *Ai, 
+ const  real_t *B,  const  real_t *C) 
+{
+  real_t *AB = _ABC;
+  real_t *AC = _ABC + K * (2 * step);
+
+  // 1. (AB_k,AC_k) = A .* (B_k,C_k) - только неизбыточные половины спектров
+  for(int k = 0; k < K; k++) {
+    const size_t offset = k * (2 * step);
+    cconv_calc_ABC(Ar, Ai, B + offset, C + offset, AB + offset, AC + offset, n);
+  }
 
-  conv_free(array);
+  // 2. (ab_k,ac_k) = ifft(AB_k,AC_k) - одним вызовом для всех каналов
+  // массивы выделены conv_alloc - план для выровненных массивов
+  FFTW(execute_split_dft_c2r)((FFTW(plan))plans.c2r(true), _ABC, _ABC + step, _ab);
 }
 
 
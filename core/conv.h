@@ -7,15 +7,47 @@
 ///
 
 #include "common.h"
+#include "spl_types.h"
 
 namespace spl {
 
-/// Размер окна циклической свертки.
+/// Размер окна циклической свертки по умолчанию.
 /// Чем больше окно циклической свертки, 
 ///  тем более эффективны алгоритмы фильтрации длинных сигналов, 
 ///  и тем менее эффективны алгоритмы фильтрации коротких сигналов.
+/// Размер окна задается при создании вычислителей (см. cconv_choose_size).
 const int CONV_WIN_SIZ = 8192;
 
+//@{
+/// Границы размера окна циклической свертки при автоматическом выборе.
+/// При N >> Ws полезная часть блока почти не растет, а время FFT растет как N log N:
+///  в тесте spectrum_block_size окна 16384 и 32768 не быстрее 4096 и 8192 ни на какой длине сигнала.
+/// Верхняя граница не действует, если 2 Ws больше нее.
+const int CONV_MIN_SIZ = 256;
+const int CONV_MAX_SIZ = 1 << 15;
+//@}
+
+/// Автоматический выбор размера окна циклической свертки (см. cconv_choose_size).
+const int CONV_SIZ_AUTO = 0;
+
+/// Количество отсчетов в половине спектра вещественного сигнала.
+/// Спектр вещественного сигнала симметричен (X[N-i] = conj(X[i])), 
+///  поэтому хранится и обрабатывается только его неизбыточная половина.
+const int CONV_SPEC_SIZ = CONV_WIN_SIZ / 2 + 1;
+
+/// Шаг между действительной и мнимой частями половины спектра.
+/// Половина спектра X хранится как X[0..CONV_SPEC_SIZ) - действительная часть и
+///  X[CONV_SPEC_STEP..CONV_SPEC_STEP+CONV_SPEC_SIZ) - мнимая часть,
+///  т.е. занимает 2 * CONV_SPEC_STEP чисел.
+/// Шаг дополнен до кратного 4, чтобы обе части были выровнены так же, как при планировании FFTW.
+const int CONV_SPEC_STEP = CONV_WIN_SIZ / 2 + 4;
+
+//@{
+/// Размер половины спектра и шаг между ее частями для окна произвольного размера \a n.
+inline int conv_spec_siz(int n) { return n / 2 + 1; }
+inline int conv_spec_step(int n) { return n / 2 + 4; }
+//@}
+
 /// Функция для выравнивания памяти по границе 16 байт.
 /// Это нужно для ускорения вычислений при использовании SSE и т.п.
 
@@ -33,36 +65,208 @@ template<typename T>
 T *conv_alloc(size_t siz) {
   return (T*) conv_alloc_low(siz * sizeof(T));
 }
+
+/// Освобождение памяти conv_alloc() владельцем std::unique_ptr.
+struct conv_deleter {
+  void operator()(void *m) const { conv_free(m); }
+};
 //@}
 
+/// Стратегия планирования FFT.
+/// Чем тщательнее планирование, тем дольше создается план и тем быстрее он исполняется.
+enum conv_plan_mode_t {
+  conv_plan_estimate, ///< FFTW_ESTIMATE - план без измерений
+  conv_plan_measure,  ///< FFTW_MEASURE - по умолчанию
+  conv_plan_patient,  ///< FFTW_PATIENT
+};
+
+/// Установка стратегии планирования для планов, создаваемых после вызова.
+/// Планы FFT создаются лениво - при первом запросе данного размера - 
+///  и хранятся в общем потокобезопасном реестре до конца работы программы.
+/// Рабочая память свертки и пакетная свертка берут планы из реестра при создании
+///  (см. cconv_plans), функции с параметром n - при каждом вызове.
+void conv_set_plan_mode(conv_plan_mode_t mode);
+
+/// Установка файла мудрости FFTW (по умолчанию "spl-fftw-wisdom", при SPL_FLOAT - "spl-fftwf-wisdom").
+/// Мудрость читается перед созданием первого плана и сохраняется после создания 
+///  каждого нового плана (кроме conv_plan_estimate). Пустой указатель отключает файл.
+void conv_set_wisdom_file(const char *file);
+
+/// Количество вызовов conv_alloc с момента запуска программы.
+/// Позволяет убедиться, что в установившемся режиме свертка не выделяет память.
+size_t conv_alloc_count();
+
+///
+/// Планы FFT размера n, взятые из реестра планов один раз.
+///
+/// Планы для выровненных массивов берутся при создании, для невыровненных - при первом
+///  использовании; дальше исполнение не обращается к реестру и не блокируется.
+/// Один объект нельзя одновременно использовать из нескольких потоков.
+///
+
+class cconv_plans {
+public:
+    /// \a howmany - количество обратных преобразований в пакете.
+    cconv_plans(int n, int howmany = 1);
+
+    //@{
+    /// Планы (типа fftw_plan) прямого real-to-complex преобразования одного массива
+    ///  и обратного complex-to-real преобразования пакета массивов.
+    void *r2c(bool aligned);
+    void *c2r(bool aligned);
+    //@}
+
+private:
+    int n, howmany;
+    void *_r2c[2], *_c2r[2];
+};
+
+///
+/// Рабочая память двойной циклической свертки.
+///
+/// Создается один раз (на вычислитель или на поток) и передается в cconv(),
+///  благодаря чему сама свертка не выделяет память и не обращается к реестру планов.
+/// Один объект нельзя одновременно использовать из нескольких потоков.
+///
+
+class cconv_workspace {
+public:
+    cconv_workspace(int n = CONV_WIN_SIZ);
+    ~cconv_workspace();
+
+    /// Планы FFT размера окна.
+    cconv_plans& plans() { return _plans; }
+
+    //@{
+    /// Буферы для произведений половин спектров AB и AC (по 2 * conv_spec_step(n) чисел).
+    real_t *AB() { return _AB; }
+    real_t *AC() { return _AB + 2 * conv_spec_step(n); }
+    //@}
+
+    /// Размер окна свертки.
+    int size() const { return n; }
+
+private:
+    int n;
+    real_t *_AB;
+    cconv_plans _plans;
+
+    cconv_workspace(const cconv_workspace&);
+    cconv_workspace& operator=(const cconv_workspace&);
+};
+
 /// Вычисление вектора A = FFT(a).
 /// Необходимо для быстрого вычисления двойной циклической свертки (a * (b,c))
-void cconv_calc_A(const double *a, double *Ar, double *Ai);
+/// Вычисляется только половина спектра: Ar и Ai по conv_spec_siz(n) элементов.
+/// Вариант с рабочей памятью \a ws использует ее планы (размер окна - ws.size()).
+void cconv_calc_A(const real_t *a, real_t *Ar, real_t *Ai, int n = CONV_WIN_SIZ);
+void cconv_calc_A(const real_t *a, real_t *Ar, real_t *Ai, cconv_workspace& ws);
 
-/// Вычисление вектора (B,C) = FFT((b,c)).
+/// Вычисление векторов B = FFT(b) и C = FFT(c).
 /// Необходимо для быстрого вычисления двойной циклической свертки (a * (b,c))
-void cconv_calc_BC(const double *b, const double *c, double *B, double *C);
+/// Сигналы b и c вещественные, поэтому B и C - половины спектров (по 2 * conv_spec_step(n) чисел).
+/// Комплексный фильтр b + ic при этом хранится двумя половинами спектров - столько же чисел,
+///  сколько его полный спектр, и умножений на него столько же: половины спектров экономят
+///  память и умножения только для вещественных сигналов (спектр A и вещественные фильтры).
+void cconv_calc_BC(const real_t *b, const real_t *c, real_t *B, real_t *C, int n = CONV_WIN_SIZ);
+void cconv_calc_BC(const real_t *b, const real_t *c, real_t *B, real_t *C, cconv_workspace& ws);
 
 /// Нормализация коэффициентов фильтра.
 /// Необходимо для быстрого вычисления двойной циклической свертки (a * (b,c))
 /// Поскольку используемая библиотека FFTW домножает результат IFFT на размер массива, 
-///  то разумно перед фильтрацией разделить коэффициенты фильтра на размер массива (CONV_WIN_SIZ).
-void cconv_normalize(double *x, size_t n);
+///  то разумно перед фильтрацией разделить коэффициенты фильтра на размер массива (\a n).
+/// \a count - количество нормализуемых чисел.
+void cconv_normalize(real_t *x, size_t count, int n = CONV_WIN_SIZ);
+
+/// Выбор размера окна циклической свертки для фильтра длины \a Ws.
+/// Выбирается степень двойки из [CONV_MIN_SIZ, CONV_MAX_SIZ], не меньшая 2 * Ws, 
+///  минимизирующая оценку времени фильтрации сигнала длины \a length.
+/// Если длина неизвестна (0), минимизируется время на один отсчет длинного сигнала.
+/// \a K - количество каналов (пар фильтров), свертываемых с одним блоком сигнала.
+int cconv_choose_size(int Ws, size_t length = 0, int K = 1);
 
 /// Вычисление модуля каждого элемента комплексного вектора.
 /// Для скорости вычисляет квадрат модуля.
-void complex_abs_split(size_t N, const double *Ar, const double *Ai, double *Am);
+/// Результат пишется сразу в \a Am - используется для копирования результата свертки в выходной буфер.
+/// Векторизовано (AVX2/AVX-512, выбор во время выполнения - см. simd.h).
+void complex_abs_split(size_t N, const real_t *Ar, const real_t *Ai, real_t *Am);
+
+/// Квадрат модуля K комплексных векторов длины \a N с транспонированием результата:
+///  Am[j * K + k] = |A_k[j]|^2, где A_k = (Ar + k * stride, Ai + k * stride).
+/// Переводит результат свертки по каналам (K x N) сразу в порядок отсчетов (N x K)
+///  без промежуточной матрицы; обход блочный, чтобы запись шла в пределах кэша.
+/// С шагом \a step > 1 берется каждый step-й отсчет: Am[j * K + k] = |A_k[j * step]|^2
+///  (прореженный выход, без векторизации - его объем в step раз меньше).
+/// Векторизовано (см. simd.h).
+void complex_abs_split_transposed(
+ size_t K, size_t N, const real_t *Ar, const real_t *Ai, size_t stride, real_t *Am,
+ size_t step = 1);
+
+/// Поэлементное умножение комплексного вектора A на два вектора: (AB,AC) = A .* (B,C).
+/// A задан раздельно (\a Ar, \a Ai), у B, C, AB, AC мнимые части отстоят от 
+///  вещественных на \a step элементов (раскладка половин спектров, см. conv_spec_step).
+/// Допускает in-place умножение: AB может совпадать с A или B, AC - с A или C
+///  (все входы отсчета читаются до записи выходов). Векторизовано (см. simd.h).
+void complex_mul_split2(
+ size_t N, const real_t *Ar, const real_t *Ai,
+ const real_t *B, const real_t *C, real_t *AB, real_t *AC, size_t step);
 
 /// Двойная циклическая свертка, рассчитанная по быстрому алгоритму.
 /// Такая циклическая свертка используется для быстрой цифровой фильтрации
 ///  по алгоритму пересечения с накоплением (overlap-save), 
 ///  в том числе при фильтрации сигнала и вычислении одновременной маскировки.
+/// Все спектры (A, B, C) - половины спектров, избыточная половина не восстанавливается:
+///  (ab,ac) вычисляются обратным преобразованием complex-to-real.
+/// Промежуточные результаты хранятся в рабочей памяти \a ws - память не выделяется.
+/// Размер окна свертки определяется рабочей памятью.
 void cconv(
- const  double *Ar, const  double *Ai, 
- const  double *C,  const  double *B, 
- double *ab, double *ac
+ const  real_t *Ar, const  real_t *Ai, 
+ const  real_t *B,  const  real_t *C, 
+ real_t *ab, real_t *ac,
+ cconv_workspace& ws
 );
 
+///
+/// Пакетная двойная циклическая свертка сразу для K каналов.
+///
+/// Вектор A = FFT(a) умножается на спектры (B_k, C_k) всех K каналов,
+///  после чего выполняется одно пакетное ("howmany") обратное преобразование Фурье
+///  вместо K отдельных вызовов cconv().
+/// Спектры каналов должны лежать в памяти подряд: матрицы B и C размера K x (2 * conv_spec_step(n)).
+/// Результаты (ab_k, ac_k) хранятся во внутреннем буфере объекта до следующего вызова execute().
+///
+
+class cconv_batch {
+public:
+    cconv_batch(int K, int n = CONV_WIN_SIZ);
+    ~cconv_batch();
+
+    /// Вычисление A = FFT(a) - то же, что cconv_calc_A(), но с планом пакетной свертки.
+    void calc_A(const real_t *a, real_t *Ar, real_t *Ai);
+
+    /// Вычисление (ab_k, ac_k) = IFFT(A .* (B_k, C_k)) для всех каналов k.
+    void execute(const real_t *Ar, const real_t *Ai, const real_t *B, const real_t *C);
+
+    //@{
+    /// Результаты свертки k-го канала (n элементов).
+    const real_t *ab(int k) const { return _ab + k * n; }
+    const real_t *ac(int k) const { return _ac + k * n; }
+    //@}
+
+    /// Количество каналов.
+    int size() const { return K; }
+
+private:
+    int K, n, step;
+    /// Произведения спектров (AB_k, AC_k) - 2K половин спектров.
+    real_t *_ABC;
+    real_t *_ab, *_ac;
+    cconv_plans plans;
+
+    cconv_batch(const cconv_batch&);
+    cconv_batch& operator=(const cconv_batch&);
+};
+
 } // namespace spl 
 
 #endif//_SPL_CONV_
@@ -0,0 +1,235 @@
+///
+/// \file  conv_simd.cpp
+/// \brief Векторные ядра комплексной арифметики для быстрой свертки
+///
+/// Комплексные векторы хранятся раздельно (split): вещественные и мнимые части
+///  в отдельных массивах, поэтому операции векторизуются без перестановок.
+/// Для каждого ядра есть скалярный вариант и варианты AVX2 и AVX-512;
+///  нужный вариант выбирается во время выполнения (см. simd.h).
+///
+
+#include "conv.h"
+#include "simd_ops.h"
+using spl::real_t;
+
+#include <algorithm>
+
+namespace {
+
+//
+// скалярные варианты
+//
+
+/// Умножение комплексных чисел.
+/// (Ar + iAi) * (Br + iBi) = ArBr - AiBi + i(ArBi + AiBr)
+/// допускает in-place умножение
+inline void complex_mul(
+    const real_t& Ar, const real_t& Ai,
+    const real_t& Br, const real_t& Bi,
+    real_t& ABr, real_t& ABi)
+{
+ real_t r = Ar * Br;
+ real_t i = Ai * Bi;
+ ABi = (Ar + Ai) * (Br + Bi) - r - i;
+ ABr = r - i;
+}
+
+void mul2_scalar(
+ size_t N, const real_t *Ar, const real_t *Ai,
+ const real_t *B, const real_t *C, real_t *AB, real_t *AC, size_t step, size_t i = 0)
+{
+  for(; i < N; i++) {
+    // все входы читаются до записи: выход может совпадать с любым из входов
+    const real_t ar = Ar[i], ai = Ai[i];
+    const real_t br = B[i], bi = B[step + i], cr = C[i], ci = C[step + i];
+    complex_mul(ar, ai, br, bi, AB[i], AB[step + i]);
+    complex_mul(ar, ai, cr, ci, AC[i], AC[step + i]);
+  }
+}
+
+void abs_scalar(size_t N, const real_t *Ar, const real_t *Ai, real_t *Am, size_t i = 0) {
+  for(; i < N; i++)
+    Am[i] = Ar[i] * Ar[i] + Ai[i] * Ai[i];
+}
+
+/// Размер полосы строк выхода при транспонировании:
+///  JB x K выходных чисел должны помещаться в кэш L2.
+const size_t ABS_T_BLOCK = 32;
+
+/// Am[j*K + k] = |A_k[j]|^2 для j из [j0, j1), k из [k0, K)
+void abs_t_scalar(
+ size_t K, size_t j0, size_t j1, const real_t *Ar, const real_t *Ai, size_t stride, 
+ real_t *Am, size_t k0 = 0)
+{
+  for(size_t k = k0; k < K; k++) {
+    const real_t *ar = Ar + k * stride, *ai = Ai + k * stride;
+    for(size_t j = j0; j < j1; j++)
+      Am[j * K + k] = ar[j] * ar[j] + ai[j] * ai[j];
+  }
+}
+
+#ifdef SPL_SIMD_X86
+
+//
+// векторные варианты
+// Операции над регистрами описаны структурами avx2_t и avx512_t (simd_ops.h),
+//  сами ядра - общий макрос SPL_CONV_KERNELS.
+//
+
+/// Ядра для набора инструкций V с атрибутом TARGET.
+/// Шаблон здесь не подходит: GCC не встраивает функции с атрибутом target
+///  в функции без него, поэтому тело ядра должно находиться в функции с атрибутом.
+///
+/// mul2: (AB,AC) = A .* (B,C), A читается один раз на оба произведения;
+///  ABr = Ar*Br - Ai*Bi, ABi = Ar*Bi + Ai*Br - два FMA и два умножения.
+/// abs:  Am = Ar .* Ar + Ai .* Ai.
+#define SPL_CONV_KERNELS(V, TARGET, suffix)                                              \
+TARGET void mul2_##suffix(                                                               \
+ size_t N, const real_t *Ar, const real_t *Ai,                                           \
+ const real_t *B, const real_t *C, real_t *AB, real_t *AC, size_t step)                  \
+{                                                                                        \
+  typedef V::vec vec;                                                                    \
+  size_t i = 0;                                                                          \
+  for(; i + V::W <= N; i += V::W) {                                                      \
+    const vec ar = V::load(Ar + i), ai = V::load(Ai + i);                                \
+    const vec br = V::load(B + i), bi = V::load(B + step + i);                           \
+    const vec cr = V::load(C + i), ci = V::load(C + step + i);                           \
+    V::store(AB + i,        V::fmsub(ar, br, V::mul(ai, bi)));                           \
+    V::store(AB + step + i, V::fmadd(ar, bi, V::mul(ai, br)));                           \
+    V::store(AC + i,        V::fmsub(ar, cr, V::mul(ai, ci)));                           \
+    V::store(AC + step + i, V::fmadd(ar, ci, V::mul(ai, cr)));                           \
+  }                                                                                      \
+  mul2_scalar(N, Ar, Ai, B, C, AB, AC, step, i);                                         \
+}                                                                                        \
+                                                                                         \
+TARGET void abs_##suffix(size_t N, const real_t *Ar, const real_t *Ai, real_t *Am) {     \
+  typedef V::vec vec;                                                                    \
+  size_t i = 0;                                                                          \
+  for(; i + V::W <= N; i += V::W) {                                                      \
+    const vec ar = V::load(Ar + i), ai = V::load(Ai + i);                                \
+    V::store(Am + i, V::fmadd(ar, ar, V::mul(ai, ai)));                                  \
+  }                                                                                      \
+  abs_scalar(N, Ar, Ai, Am, i);                                                          \
+}
+
+SPL_CONV_KERNELS(spl::avx2_t, SPL_TARGET_AVX2, avx2)
+SPL_CONV_KERNELS(spl::avx512_t, SPL_TARGET_AVX512, avx512)
+
+/// Квадрат модуля с транспонированием блоками 4 x 4 в регистрах:
+///  четыре канала по четыре отсчета -> четыре строки выхода по четыре канала.
+/// Для AVX-512 используется этот же вариант: выход пишется короткими строками
+///  по 4 канала, и более широкие регистры здесь выигрыша не дают.
+#ifdef SPL_FLOAT
+
+SPL_TARGET_AVX2 void abs_t_avx2(
+ size_t K, size_t N, const real_t *Ar, const real_t *Ai, size_t stride, real_t *Am)
+{
+  const size_t K4 = K & ~size_t(3), N4 = N & ~size_t(3);
+  for(size_t j0 = 0; j0 < N4; j0 += ABS_T_BLOCK) {
+    const size_t j1 = std::min(j0 + ABS_T_BLOCK, N4);
+    for(size_t k = 0; k < K4; k += 4) {
+      for(size_t j = j0; j < j1; j += 4) {
+        __m128 r[4];
+        for(int q = 0; q < 4; q++) {
+          const __m128 ar = _mm_loadu_ps(Ar + (k + q) * stride + j);
+          const __m128 ai = _mm_loadu_ps(Ai + (k + q) * stride + j);
+          r[q] = _mm_fmadd_ps(ar, ar, _mm_mul_ps(ai, ai));
+        }
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+        for(int p = 0; p < 4; p++)
+          _mm_storeu_ps(Am + (j + p) * K + k, r[p]);
+      }
+    }
+    abs_t_scalar(K, j0, j1, Ar, Ai, stride, Am, K4);
+  }
+  abs_t_scalar(K, N4, N, Ar, Ai, stride, Am);
+}
+
+#else
+
+SPL_TARGET_AVX2 void abs_t_avx2(
+ size_t K, size_t N, const real_t *Ar, const real_t *Ai, size_t stride, real_t *Am)
+{
+  const size_t K4 = K & ~size_t(3), N4 = N & ~size_t(3);
+  for(size_t j0 = 0; j0 < N4; j0 += ABS_T_BLOCK) {
+    const size_t j1 = std::min(j0 + ABS_T_BLOCK, N4);
+    for(size_t k = 0; k < K4; k += 4) {
+      for(size_t j = j0; j < j1; j += 4) {
+        __m256d r[4];
+        for(int q = 0; q < 4; q++) {
+          const __m256d ar = _mm256_loadu_pd(Ar + (k + q) * stride + j);
+          const __m256d ai = _mm256_loadu_pd(Ai + (k + q) * stride + j);
+          r[q] = _mm256_fmadd_pd(ar, ar, _mm256_mul_pd(ai, ai));
+        }
+        // транспонирование 4 x 4: сначала пары внутри 128-битных половин, затем половины
+        const __m256d t0 = _mm256_unpacklo_pd(r[0], r[1]);
+        const __m256d t1 = _mm256_unpackhi_pd(r[0], r[1]);
+        const __m256d t2 = _mm256_unpacklo_pd(r[2], r[3]);
+        const __m256d t3 = _mm256_unpackhi_pd(r[2], r[3]);
+        _mm256_storeu_pd(Am + (j + 0) * K + k, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(Am + (j + 1) * K + k, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(Am + (j + 2) * K + k, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(Am + (j + 3) * K + k, _mm256_permute2f128_pd(t1, t3, 0x31));
+      }
+    }
+    abs_t_scalar(K, j0, j1, Ar, Ai, stride, Am, K4);
+  }
+  abs_t_scalar(K, N4, N, Ar, Ai, stride, Am);
+}
+
+#endif
+
+#endif
+
+}
+
+NAMESPACE_SPL_BEGIN;
+
+void complex_mul_split2(
+ size_t N, const real_t *Ar, const real_t *Ai,
+ const real_t *B, const real_t *C, real_t *AB, real_t *AC, size_t step)
+{
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512: mul2_avx512(N, Ar, Ai, B, C, AB, AC, step); return;
+  case simd_avx2:   mul2_avx2(N, Ar, Ai, B, C, AB, AC, step); return;
+  default: break;
+  }
+#endif
+  mul2_scalar(N, Ar, Ai, B, C, AB, AC, step);
+}
+
+void complex_abs_split(size_t N, const real_t *Ar, const real_t *Ai, real_t *Am) {
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512: abs_avx512(N, Ar, Ai, Am); return;
+  case simd_avx2:   abs_avx2(N, Ar, Ai, Am); return;
+  default: break;
+  }
+#endif
+  abs_scalar(N, Ar, Ai, Am);
+}
+
+void complex_abs_split_transposed(
+ size_t K, size_t N, const real_t *Ar, const real_t *Ai, size_t stride, real_t *Am,
+ size_t step)
+{
+  if(step > 1) {
+    for(size_t k = 0; k < K; k++) {
+      const real_t *ar = Ar + k * stride, *ai = Ai + k * stride;
+      for(size_t j = 0; j < N; j++)
+        Am[j * K + k] = ar[j * step] * ar[j * step] + ai[j * step] * ai[j * step];
+    }
+    return;
+  }
+#ifdef SPL_SIMD_X86
+  if(simd_level() >= simd_avx2) {
+    abs_t_avx2(K, N, Ar, Ai, stride, Am);
+    return;
+  }
+#endif
+  for(size_t j0 = 0; j0 < N; j0 += ABS_T_BLOCK)
+    abs_t_scalar(K, j0, std::min(j0 + ABS_T_BLOCK, N), Ar, Ai, stride, Am);
+}
+
+NAMESPACE_SPL_END;
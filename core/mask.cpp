@@ -15,6 +15,7 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <deque>
 
 #include "../io/iobit.h"
 #include "../io/iomem.h"
@@ -173,6 +174,113 @@ private:
 
 
 
+///
+/// Упакованные кадры маски.
+///
+
+void mask_pack(int K, const mask_t *mask, mask_word_t *words) {
+    std::fill_n(words, mask_frame_words(K), 0);
+    for (int k = 0; k < K; k++) {
+        if (mask[k])
+            words[k / MASK_WORD_BITS] |= mask_word_t(1) << (k % MASK_WORD_BITS);
+    }
+}
+
+void mask_unpack(int K, const mask_word_t *words, mask_t *mask) {
+    for (int k = 0; k < K; k++) {
+        mask[k] = (words[k / MASK_WORD_BITS] >> (k % MASK_WORD_BITS)) & 1;
+    }
+}
+
+mask_pack_istream::mask_pack_istream(istream<mask_t>& str, int K_) :
+    io::iwrap<mask_word_t, mask_t>(str), K(K_), W(int(mask_frame_words(K_))), _pos(W)
+{
+    _frame = spl_alloc<mask_t>(K);
+    _words = spl_alloc<mask_word_t>(W);
+}
+
+mask_pack_istream::~mask_pack_istream() {
+    spl_free(_frame);
+    spl_free(_words);
+}
+
+size_t mask_pack_istream::read(mask_word_t *buf, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        // если кадр кончился - читаем и упаковываем следующий (только целиком)
+        if (_pos >= W) {
+            if (_understream->read(_frame, K) != K) break;
+            mask_pack(K, _frame, _words);
+            _pos = 0;
+        }
+        const size_t n = std::min(size_t(W - _pos), count - i);
+        std::copy(_words + _pos, _words + _pos + n, buf + i);
+        _pos += int(n); i += n;
+    }
+    return i;
+}
+
+mask_unpack_ostream::mask_unpack_ostream(ostream<mask_t>& str, int K_) :
+    io::owrap<mask_word_t, mask_t>(str), K(K_), W(int(mask_frame_words(K_))), _pos(0), _written(0)
+{
+    _frame = spl_alloc<mask_t>(K);
+    _words = spl_alloc<mask_word_t>(W);
+}
+
+mask_unpack_ostream::~mask_unpack_ostream() {
+    spl_free(_frame);
+    spl_free(_words);
+}
+
+size_t mask_unpack_ostream::write(const mask_word_t *buf, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        const size_t n = std::min(size_t(W - _pos), count - i);
+        std::copy(buf + i, buf + i + n, _words + _pos);
+        _pos += int(n); i += n;
+        // кадр собран - распаковываем и выводим
+        if (_pos == W) {
+            mask_unpack(K, _words, _frame);
+            const size_t w = _understream->write(_frame, K);
+            _written += w;
+            _pos = 0;
+            if (w < size_t(K)) break;
+        }
+    }
+    return i;
+}
+
+mask_pack_ostream::mask_pack_ostream(ostream<mask_word_t>& str, int K_) :
+    io::owrap<mask_t, mask_word_t>(str), K(K_), W(int(mask_frame_words(K_))), _pos(0), _written(0)
+{
+    _frame = spl_alloc<mask_t>(K);
+    _words = spl_alloc<mask_word_t>(W);
+}
+
+mask_pack_ostream::~mask_pack_ostream() {
+    spl_free(_frame);
+    spl_free(_words);
+}
+
+size_t mask_pack_ostream::write(const mask_t *buf, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        const size_t n = std::min(size_t(K - _pos), count - i);
+        std::copy(buf + i, buf + i + n, _frame + _pos);
+        _pos += int(n); i += n;
+        // кадр собран - упаковываем и выводим
+        if (_pos == K) {
+            mask_pack(K, _frame, _words);
+            const size_t w = _understream->write(_words, W);
+            _written += w;
+            _pos = 0;
+            if (w < size_t(W)) break;
+        }
+    }
+    return i;
+}
+
+
 /// Функция расчета окна фильтров маскировки.
 /// Применяется для предварительного расчета - перед выделением памяти.
 
@@ -199,13 +307,13 @@ static int mask_window_size(const freq_scale_t& s, const mask_params_t& p) {
 /// Функция генерации маскирующей функции.
 static void mask_win(
 	const freq_scale_t& s, // массив резонансных частот фильтров
-	double *H,           // выходной массив - коэффициенты маскирующей функции
+	real_t *H,           // выходной массив - коэффициенты маскирующей функции
 	int k, 
 	int Ws, 
 	const mask_params_t& p
 ) {
 	size_t K = s.size();
-	double *H2 = H + Ws;
+	real_t *H2 = H + Ws;
 
 	// стандартное отклонение (СКО) функции Гаусса
 	double std = model::mask_std(s[k], p.delta);
@@ -259,13 +367,35 @@ bool freq_mask_calculator::init(const freq_scale_t& s, const mask_params_t& p)
     K = s.size();
     Ws = mask_window_size(s, p);
     size_t N = K * Ws;
-    H = conv_alloc<double>(N);
-    if (H == 0) 
+    const int num_blocks = (K + MASK_BAND_BLOCK - 1) / MASK_BAND_BLOCK;
+    // память освобождается владельцами и при исключении на любом шаге
+    H.reset(conv_alloc<real_t>(N));
+    band.resize(2 * num_blocks);
+    std::unique_ptr<real_t[], conv_deleter> win(conv_alloc<real_t>(Ws));
+    if (!H || !win)
         throw "Can't allocate memory for mask filters coefficients";
 
-	// посчитать коэффициенты
+	// посчитать коэффициенты и сохранить их транспонированными
 	for(int k = 0; k < K; k++) {
-		mask_win(s, H + k * Ws, k, Ws/2, p);
+		mask_win(s, win.get(), k, Ws/2, p);
+		for(int m = 0; m < Ws; m++)
+			H[m * K + k] = win[m];
+	}
+
+	// интервалы ненулевых коэффициентов по блокам каналов:
+	// без учета краевого эффекта крайние каналы маскируются неполным окном
+	for(int b = 0; b < num_blocks; b++) {
+		int m0 = Ws, m1 = 0;
+		for(int k = b * MASK_BAND_BLOCK; k < std::min((b + 1) * MASK_BAND_BLOCK, K); k++) {
+			for(int m = 0; m < Ws; m++) {
+				if(H[m * K + k] != 0) {
+					m0 = std::min(m0, m);
+					m1 = std::max(m1, m + 1);
+				}
+			}
+		}
+		band[2*b] = std::min(m0, m1);
+		band[2*b+1] = m1;
 	}
 
 	return true;
@@ -284,13 +414,14 @@ bool freq_mask_calculator::init(const freq_scale_t& s, const mask_params_t& p)
 /// В данной функции производится предварительное приготовление к быстрому вычислению:
 ///  вычисляется Фурье (вектор А) от маскирующей функции.
 /// 
-/// В структуре фильтров \a f уже должно быть выделено место (2*CONV_WIN_SIZ) 
-///  для помещения коэффициентов фильтрации.
+/// Хранится только половина спектра A: 2*conv_spec_step(N) чисел 
+///  (см. \ref CONV_SPEC_STEP).
 /// 
 
 bool freq_mask_calculator_fast::init(
 	const freq_scale_t& s, 
-	const mask_params_t& p) 
+	const mask_params_t& p,
+	size_t length) 
 {
     K = s.size();
     scale_form_t sc_form = s.get_form(true, K - 2);
@@ -299,23 +430,31 @@ bool freq_mask_calculator_fast::init(
         throw "Only model scale form is supported in freq_mask_calculator_fast";
 
     Ws = mask_window_size(s, p);
-    size_t N = 2 * CONV_WIN_SIZ;
-    H = conv_alloc<double>(N);
-    if (H == 0)
+
+    // размер окна свертки; спектр расширяется на Ws отсчетов на каждом кадре
+    if (N == CONV_SIZ_AUTO)
+        N = cconv_choose_size(Ws, length / K * (K + Ws));
+    if (N < 2 * Ws)
+        return false;
+
+    const int step = conv_spec_step(N);
+    H.reset(conv_alloc<real_t>(2 * step));
+    std::unique_ptr<real_t[], conv_deleter> buf(conv_alloc<real_t>(N));
+    if (!H || !buf)
         throw "Can't allocate memory for mask filters coefficients";
 
-    double tmp[CONV_WIN_SIZ];
+    real_t *tmp = buf.get();
 	// вычисляет маскирующую функцию для k = K/2
 	// выбор конкретного k на самом деле неважен
 	mask_win(s, tmp, K/2, Ws/2, p); // заполняет первые Ws/2 байт
 	// меняем направление - т.к. свертка поменяет его еще раз ;)
 	std::reverse(tmp, tmp + Ws);
 	// заполняем остаток нулями
-	std::fill(tmp + Ws, tmp + CONV_WIN_SIZ, 0.0);
+	std::fill(tmp + Ws, tmp + N, 0.0);
 	// предвычисление вектора A
-	cconv_calc_A(tmp, H, H + CONV_WIN_SIZ);
+	cconv_calc_A(tmp, H.get(), H.get() + step, N);
 	// нормировка вектора А
-	cconv_normalize(H, 2 * CONV_WIN_SIZ);
+	cconv_normalize(H.get(), 2 * step, N);
 
 	return true;
 }
@@ -337,26 +476,112 @@ freq_mask_calculator::freq_mask_calculator(const freq_scale_t& s, const mask_par
 
 freq_mask_calculator::~freq_mask_calculator()
 {
-    conv_free(H);
 }
 
-freq_mask_calculator_fast::freq_mask_calculator_fast(const freq_scale_t& s, double ksi)
+freq_mask_calculator_fast::freq_mask_calculator_fast(const freq_scale_t& s, double ksi) :
+    N(CONV_SIZ_AUTO)
 {
     mask_params_t p = mask_params_t::DEFAULT;
     p.ksi = ksi;
-    if (!init(s, p))
+    if (!init(s, p, 0))
         throw "Error while generating mask filters";
 }
 
-freq_mask_calculator_fast::freq_mask_calculator_fast(const freq_scale_t& s, const mask_params_t& p)
+freq_mask_calculator_fast::freq_mask_calculator_fast(const freq_scale_t& s, const mask_params_t& p, int N, size_t length) :
+    N(N)
 {
-    if (!init(s, p))
+    if (!init(s, p, length))
         throw "Error while generating mask filters";
 }
 
 freq_mask_calculator_fast::~freq_mask_calculator_fast()
 {
-    conv_free(H);
+}
+
+
+///
+/// Маскировка по кадрам: окно маскировки.
+///
+/// Окно одинаково для всех каналов модельной шкалы, но в единицах каналов 
+///  несимметрично (шкала нелинейна по частоте), поэтому используется как есть - 
+///  без замены симметричной функцией Гаусса.
+/// Края окна, меньшие tolerance * max(h), отбрасываются: при tolerance = ksi 
+///  это та же граница, по которой окно обрезается при генерации (gauss_border).
+///
+
+freq_mask_calculator_frame::freq_mask_calculator_frame(
+    const freq_scale_t& s, const mask_params_t& p, double tolerance) :
+    m0(0)
+{
+    K = s.size();
+    if (s.get_form(true, K - 2) != scale_form_t::model)
+        throw "Only model scale form is supported in freq_mask_calculator_frame";
+
+    Ws = mask_window_size(s, p);
+    h.reset(conv_alloc<real_t>(Ws));
+    if (!h)
+        throw "Can't allocate memory for mask filters coefficients";
+
+    // окно маскировки одинаково для всех каналов - берем для k = K/2
+    mask_win(s, h.get(), K/2, Ws/2, p);
+
+    // отбрасываем края окна ниже допуска
+    const real_t threshold = real_t((tolerance < 0 ? p.ksi : tolerance) * *std::max_element(h.get(), h.get() + Ws));
+    int m1 = Ws;
+    while (m0 < m1 - 1 && h[m0] < threshold) m0++;
+    while (m1 - 1 > m0 && h[m1 - 1] < threshold) m1--;
+    Wt = m1 - m0;
+}
+
+freq_mask_calculator_frame::~freq_mask_calculator_frame()
+{
+}
+
+///
+/// Маскировка по кадрам: каждый кадр читается, маскируется и выводится сразу.
+///
+
+size_t freq_mask_calculator_frame::execute(istream<spectrum_t>& input, ostream<mask_word_t>& mask) const
+{
+    // прореживание во времени: маскируется только каждый hop-й кадр
+    io::iwrapdecimate<spectrum_t> decimated(input, K, hop);
+    istream<spectrum_t>& spectrum = hop > 1 ? decimated : input;
+    const int Ws2 = Ws / 2;
+    const size_t W = mask_frame_words(K);
+    spectrum_t *spec_wide = spl_alloc<spectrum_t>(Ws2 + K + Ws2 + K);
+    spectrum_t *spec_input = spec_wide + Ws2;
+    spectrum_t *spec_sum = spec_input + K + Ws2;
+    mask_word_t *out_buf = spl_alloc<mask_word_t>(W);
+    if (!spec_wide || !out_buf) {
+        spl_free(spec_wide);
+        spl_free(out_buf);
+        return 0;
+    }
+
+    size_t written = 0;
+    while (!mask.eos() && spectrum.read(spec_input, K) == K) {
+
+        // расширение области частот спектра
+        std::fill(spec_wide, spec_input, spec_input[0]);
+        std::fill(spec_input + K, spec_input + K + Ws2, spec_input[K-1]);
+
+        // свертка с окном (без отброшенных краев)
+        mask_conv_sum(K, h.get() + m0, Wt, spec_wide + m0, spec_sum);
+
+        mask_compare_pack(K, spec_input, spec_sum, out_buf);
+        written += mask.write(out_buf, W);
+    }
+
+    spl_free(spec_wide);
+    spl_free(out_buf);
+    return written;
+}
+
+size_t freq_mask_calculator_frame::execute(istream<spectrum_t>& spectrum, ostream<mask_t>& mask) const
+{
+    mask_unpack_ostream packed(mask, K);
+    execute(spectrum, packed);
+    return packed.written();
 }
 
 
@@ -372,62 +597,97 @@ freq_mask_calculator_fast::~freq_mask_calculator_fast()
 ///  и вызывает данную функцию.
 /// Это обеспечивает единство вычислений, вне зависимости от используемых типов потоков.
 /// 
-/// Функция работает по наивному алгоритму, без оптимизаций.
+/// Функция работает по прямому алгоритму (умножение ленточной матрицы на кадр спектра)
+///  и применима к шкале любой формы. Кадры обрабатываются пачками по MASK_FRAMES 
+///  векторным ядром mask_band_sum(), маска пачки выводится одним вызовом write().
 ///
 
-size_t freq_mask_calculator::execute(istream<spectrum_t>& spectrum, ostream<mask_t>& mask) const 
+size_t freq_mask_calculator::execute(istream<spectrum_t>& input, ostream<mask_word_t>& mask) const 
 {
+    // прореживание во времени: маскируется только каждый hop-й кадр
+    io::iwrapdecimate<spectrum_t> decimated(input, K, hop);
+    istream<spectrum_t>& spectrum = hop > 1 ? decimated : input;
     int Ws2 = Ws / 2;
-	spectrum_t *spec_wide1 = spl_alloc<spectrum_t>(Ws2 + K + Ws2);
-	spectrum_t *spec_input = spec_wide1 + Ws2;
-	spectrum_t *spec_wide2 = spec_input + K;
-	if(!spec_wide1) return 0;
+    const size_t wide = Ws2 + K + Ws2;
+    const size_t W = mask_frame_words(K);
+	// MASK_FRAMES расширенных кадров, суммы маскировки и выходная маска
+	spectrum_t *spec_wide = spl_alloc<spectrum_t>(MASK_FRAMES * (wide + K));
+	spectrum_t *spec_sum = spec_wide + MASK_FRAMES * wide;
+	mask_word_t *out_buf = spl_alloc<mask_word_t>(MASK_FRAMES * W);
+	if(!spec_wide || !out_buf) {
+		spl_free(spec_wide);
+		spl_free(out_buf);
+		return 0;
+	}
 
 	size_t written = 0;
 
 	// основной цикл маскировки
-	while(spectrum.read(spec_input, K) == K && !mask.eos()) {
-
-		// расширение области частот спектра
-		std::fill(spec_wide1, spec_wide1 + Ws2, spec_input[0]);
-		std::fill(spec_wide2, spec_wide2 + Ws2, spec_input[K-1]);
-
-		// цикл расчета маскировки:
-		double *pH = H;
-		for(size_t k = 0; k < K; k++) {
-			double sum = 0;
-			for(int m = -Ws2; m <= Ws2; m++) {
-				sum += spec_input[k+m] * (*pH++);
+	bool last = false;
+	while(!last && !mask.eos()) {
+
+		// читаем до MASK_FRAMES кадров и расширяем область частот каждого
+		size_t F = 0;
+		for(; F < MASK_FRAMES; F++) {
+			spectrum_t *spec_input = spec_wide + F * wide + Ws2;
+			if(spectrum.read(spec_input, K) != K) {
+				last = true;
+				break;
 			}
-			written += mask.put(spec_input[k] > sum);
+			std::fill(spec_input - Ws2, spec_input, spec_input[0]);
+			std::fill(spec_input + K, spec_input + K + Ws2, spec_input[K-1]);
+		}
+		if(F == 0) break;
+
+		// суммы маскировки для всех кадров
+		mask_band_sum(K, H.get(), band.data(), F, spec_wide, wide, spec_sum);
+
+		// маска: отсчет не замаскирован, если он больше суммы - сразу упакованная
+		for(size_t f = 0; f < F; f++) {
+			mask_compare_pack(K, spec_wide + f * wide + Ws2, spec_sum + f * K, out_buf + f * W);
 		}
+		written += mask.write(out_buf, F * W);
 	}
 
-	spl_free(spec_wide1);
+	spl_free(spec_wide);
+	spl_free(out_buf);
 	return written;
 }
 
+size_t freq_mask_calculator::execute(istream<spectrum_t>& spectrum, ostream<mask_t>& mask) const 
+{
+	mask_unpack_ostream packed(mask, K);
+	execute(spectrum, packed);
+	return packed.written();
+}
+
 
 ///
 /// Потоковая одновременная маскировка - быстрый вариант.
 /// Вызывается только для модельной шкалы частот.
 ///
 
-size_t freq_mask_calculator_fast::execute(istream<spectrum_t>& spectrum, ostream<mask_t>& mask) const
+size_t freq_mask_calculator_fast::execute(istream<spectrum_t>& input, ostream<mask_t>& mask) const
 {
+    // прореживание во времени: маскируется только каждый hop-й кадр
+    io::iwrapdecimate<spectrum_t> decimated(input, K, hop);
+    istream<spectrum_t>& spectrum = hop > 1 ? decimated : input;
     int Ws2 = Ws/2;
-	size_t Os = CONV_WIN_SIZ - Ws + 1;
+	size_t Os = N - Ws + 1;
+	const int step = conv_spec_step(N);
 
 	// Два буфера для чтения спектра
-	spectrum_t *input_buf1 = conv_alloc<spectrum_t>(CONV_WIN_SIZ * 6 + 2);
-	spectrum_t *input_buf2 = input_buf1 + CONV_WIN_SIZ;
-	// Четыре временных буфера - B, C, abcr, abci
-	spectrum_t *tmp_buf1 = input_buf2 + CONV_WIN_SIZ;
-	spectrum_t *tmp_buf2 = tmp_buf1 + CONV_WIN_SIZ;
-	spectrum_t *tmp_buf3 = tmp_buf2 + CONV_WIN_SIZ;
-	spectrum_t *tmp_buf4 = tmp_buf3 + CONV_WIN_SIZ;
+	spectrum_t *input_buf1 = conv_alloc<spectrum_t>(N * 4 + step * 4);
+	spectrum_t *input_buf2 = input_buf1 + N;
+	// Четыре временных буфера - B, C (половины спектров), abcr, abci
+	spectrum_t *tmp_buf1 = input_buf2 + N;
+	spectrum_t *tmp_buf2 = tmp_buf1 + 2 * step;
+	spectrum_t *tmp_buf3 = tmp_buf2 + 2 * step;
+	spectrum_t *tmp_buf4 = tmp_buf3 + N;
 	// один выходной буфер
-	mask_t *out_buf = spl_alloc<mask_t>(CONV_WIN_SIZ * 2);
+	mask_t *out_buf = spl_alloc<mask_t>(N * 2);
+	// рабочая память свертки - одна на весь вызов
+	cconv_workspace ws(N);
 
 	// i/o wrappers для расширения/сужения шкалы частот:
     istream_block_extend<spectrum_t> spectrum_ext(spectrum, K, Ws);
@@ -446,28 +706,28 @@ size_t freq_mask_calculator_fast::execute(istream<spectrum_t>& spectrum, ostream
 	while(!spectrum_ext.eos() && !mask_ext.eos() || N2 > Os - Ws2) { // последний блок обрабатывается только на следующей итерации
 
 		// копируем из конца второго буфера в начало первого
-		std::copy(input_buf2 + Os, input_buf2 + CONV_WIN_SIZ, input_buf1);
+		std::copy(input_buf2 + Os, input_buf2 + N, input_buf1);
 		// читаем первый буфер 
 		N1 = spectrum_ext.read(input_buf1 + 2*Ws2, Os);
 		// если прочиталось меньше, чем нужно - остаток заполняем нулями
 		if(N1 < Os) {
-			std::fill(input_buf1 + 2*Ws2 + N1, input_buf1 + CONV_WIN_SIZ, 0);
+			std::fill(input_buf1 + 2*Ws2 + N1, input_buf1 + N, 0);
 		}
 
 		// копируем из конца первого буфера в начало второго
-		std::copy(input_buf1 + Os, input_buf1 + CONV_WIN_SIZ, input_buf2);
+		std::copy(input_buf1 + Os, input_buf1 + N, input_buf2);
 		// читаем второй буфер
 		N2 = spectrum_ext.read(input_buf2 + 2*Ws2, Os);
 		// если прочиталось меньше, чем нужно - остаток заполняем нулями
 		if(N2 < Os) {
-			std::fill(input_buf2 + 2*Ws2 + N2, input_buf2 + CONV_WIN_SIZ, 0);
+			std::fill(input_buf2 + 2*Ws2 + N2, input_buf2 + N, 0);
 		}
 
 		// считаем B, C
-		cconv_calc_BC(input_buf1, input_buf2, tmp_buf1, tmp_buf2);
+		cconv_calc_BC(input_buf1, input_buf2, tmp_buf1, tmp_buf2, ws);
 
 		// свертка
-		cconv(H, H + CONV_WIN_SIZ, tmp_buf1, tmp_buf2, tmp_buf3, tmp_buf4);
+		cconv(H.get(), H.get() + step, tmp_buf1, tmp_buf2, tmp_buf3, tmp_buf4, ws);
 
 		int j = 0;
 		// вычисляем результат маскировки для обоих буферов:
@@ -490,6 +750,197 @@ size_t freq_mask_calculator_fast::execute(istream<spectrum_t>& spectrum, ostream
 	return written;
 }
 
+size_t freq_mask_calculator_fast::execute(istream<spectrum_t>& spectrum, ostream<mask_word_t>& mask) const
+{
+    mask_pack_ostream packed(mask, K);
+    execute(spectrum, packed);
+    return packed.written();
+}
+
+///
+/// Последовательная маскировка.
+///
+
+namespace {
+
+/// Чтение спектра с попутным вычислением последовательной маски:
+///  каждый прочитанный кадр проходит шаг маскировки, упакованный результат ставится в очередь.
+class temp_mask_istream : public io::iwrap<spectrum_t>
+{
+public:
+    temp_mask_istream(istream<spectrum_t>& str, int K_, real_t a_, real_t c_) :
+        io::iwrap<spectrum_t>(str), K(K_), W(mask_frame_words(K_)), a(a_), c(c_), _pos(0)
+    {
+        _frame = spl_alloc<spectrum_t>(K);
+        _E = spl_alloc<spectrum_t>(K);
+        _words = spl_alloc<mask_word_t>(W);
+        std::fill_n(_E, K, spectrum_t(0));
+    }
+
+    ~temp_mask_istream() {
+        spl_free(_frame);
+        spl_free(_E);
+        spl_free(_words);
+    }
+
+    size_t read(spectrum_t *buf, size_t count) override {
+        const size_t r = _understream->read(buf, count);
+        for (size_t i = 0; i < r; ) {
+            const size_t n = std::min(size_t(K - _pos), r - i);
+            std::copy(buf + i, buf + i + n, _frame + _pos);
+            _pos += int(n); i += n;
+            if (_pos == K) {
+                mask_temp_step(K, a, c, _frame, _E, _words);
+                queue.insert(queue.end(), _words, _words + W);
+                _pos = 0;
+            }
+        }
+        return r;
+    }
+
+    /// Последовательная маска прочитанных кадров, еще не наложенная на выход.
+    std::deque<mask_word_t> queue;
+
+private:
+    const int K;
+    const size_t W;
+    const real_t a, c;
+    spectrum_t *_frame, *_E;
+    mask_word_t *_words;
+    int _pos;
+};
+
+/// Запись маски с наложением (И) последовательной маски из очереди.
+/// Выход вычислителя прорежен с шагом \a hop: после каждого кадра из очереди отбрасываются
+///  (hop - 1) кадров - перед следующим кадром, когда они уже прочитаны.
+/// Кадр выводится после того, как прочитан, поэтому при наложении очередь не пуста;
+///  иначе шаги не совпадают - запись прекращается (eos). После вывода всех кадров в очереди
+///  остаются не больше (hop - 1) отбрасываемых кадров, иначе шаги тоже не совпадают (см. matched()).
+class temp_mask_and_ostream : public io::owrap<mask_word_t>
+{
+public:
+    temp_mask_and_ostream(ostream<mask_word_t>& str, std::deque<mask_word_t>& queue, size_t W, int hop) :
+        io::owrap<mask_word_t>(str), _queue(queue), W(W), _drop(W * (hop - 1)),
+        _skip(0), _word(0), _written(0), _failed(false) {}
+
+    size_t write(const mask_word_t *buf, size_t count) override {
+        mask_word_t tmp[256];
+        size_t i = 0;
+        while (i < count && !_failed) {
+            const size_t n = std::min(count - i, sizeof(tmp) / sizeof(tmp[0]));
+            size_t j = 0;
+            for (; j < n; j++) {
+                if (_word == 0) {
+                    if (_queue.size() < _skip + W) {
+                        _failed = true;
+                        break;
+                    }
+                    _queue.erase(_queue.begin(), _queue.begin() + _skip);
+                    _skip = 0;
+                }
+                tmp[j] = buf[i + j] & _queue.front();
+                _queue.pop_front();
+                if (++_word == W) {
+                    _word = 0;
+                    _skip = _drop;
+                }
+            }
+            const size_t w = _understream->write(tmp, j);
+            _written += w; i += w;
+            if (w < j) break;
+        }
+        return i;
+    }
+
+    bool eos() const override {
+        return _failed || _understream->eos();
+    }
+
+    size_t written() const { return _written; }
+    bool failed() const { return _failed; }
+
+    /// Каждому выведенному кадру нашелся кадр последовательной маски, лишних кадров нет.
+    bool matched() const { return !_failed && _word == 0 && _queue.size() <= _skip; }
+
+private:
+    std::deque<mask_word_t>& _queue;
+    const size_t W, _drop;
+    size_t _skip, _word;
+    size_t _written;
+    bool _failed;
+};
+
+}
+
+temp_mask_calculator::temp_mask_calculator(
+    const freq_scale_t& s, freq_t F, const temp_mask_params_t& p,
+    const io::filter<spectrum_t, mask_word_t> *freq) :
+    K(s.size()), a(real_t(exp(-1.0 / (p.tau * F)))), rho(real_t(p.rho)), freq(freq)
+{
+    if (K <= 0 || !(p.tau > 0) || !(F > 0))
+        throw "Invalid temporal masking parameters";
+}
+
+size_t temp_mask_calculator::execute(istream<spectrum_t>& spectrum, ostream<mask_word_t>& mask) const
+{
+    // совмещение с одновременной маскировкой - ее вычислитель читает спектр через temporal
+    if (freq) {
+        temp_mask_istream temporal(spectrum, K, a, rho * a);
+        temp_mask_and_ostream combined(mask, temporal.queue, mask_frame_words(K), hop);
+        freq->execute(temporal, combined);
+        // лишние кадры в очереди - ошибка, только если спектр прочитан до конца
+        //  (иначе выход закрылся раньше и оставшиеся кадры просто не выведены)
+        if (!combined.matched() && (combined.failed() || spectrum.eos()))
+            throw "Temporal mask is not ready for a frequency mask frame: hop sizes differ";
+        return combined.written();
+    }
+
+    const size_t W = mask_frame_words(K);
+    spectrum_t *frame = spl_alloc<spectrum_t>(K + K);
+    spectrum_t *E = frame + K;
+    mask_word_t *out_buf = spl_alloc<mask_word_t>(W);
+    if (!frame || !out_buf) {
+        spl_free(frame);
+        spl_free(out_buf);
+        return 0;
+    }
+    std::fill_n(E, K, spectrum_t(0));
+
+    // порог обновляется по всем кадрам, выводится каждый hop-й
+    size_t written = 0;
+    for (size_t t = 0; !mask.eos() && spectrum.read(frame, K) == size_t(K); t++) {
+        mask_temp_step(K, a, rho * a, frame, E, out_buf);
+        if (t % hop == 0)
+            written += mask.write(out_buf, W);
+    }
+
+    spl_free(frame);
+    spl_free(out_buf);
+    return written;
+}
+
+size_t temp_mask_calculator::execute(istream<spectrum_t>& spectrum, ostream<mask_t>& mask) const
+{
+    mask_unpack_ostream packed(mask, K);
+    execute(spectrum, packed);
+    return packed.written();
+}
+
+size_t mask_memory(const freq_scale_t& scale, size_t N, const spectrum_t *spectrum, mask_word_t *mask, const mask_params_t& p)
+{
+    size_t K = scale.size();
+    io::imstream<spectrum_t> input(spectrum, N * K);
+    io::omstream<mask_word_t> output(mask, N * mask_frame_words(K));
+    if (scale.get_form(true) == scale_form_t::model) {
+        freq_mask_calculator_fast calc(scale, p);
+        return calc.execute(input, output);
+    }
+    else {
+        freq_mask_calculator calc(scale, p);
+        return calc.execute(input, output);
+    }
+}
+
 size_t mask_memory(const freq_scale_t& scale, size_t N, const spectrum_t *spectrum, mask_t *mask, const mask_params_t& p)
 {
     size_t K = scale.size();
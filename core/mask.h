@@ -7,12 +7,125 @@
 ///
 
 #include "config.h"
+#include "conv.h"
 #include "../io/io.h"
+#include "../io/iowrap.h"
+#include <memory>
+#include <vector>
 
 NAMESPACE_SPL_BEGIN;
 
+/// Количество каналов в блоке ленточной матрицы маскировки: 
+///  для каждого блока хранится общий интервал ненулевых коэффициентов.
+const int MASK_BAND_BLOCK = 16;
+
+/// Количество кадров спектра, обрабатываемых freq_mask_calculator за один проход.
+const int MASK_FRAMES = 8;
+
+/// Одновременная маскировка на шкале произвольной формы как ленточное умножение:
+///  sum[f * K + k] = sum_m H[m * K + k] * x[f * x_step + k + m], m из [band[2b], band[2b+1]), 
+///  где b = k / MASK_BAND_BLOCK.
+/// \a x - \a F кадров спектра, расширенных на Ws/2 отсчетов с каждой стороны.
+/// Векторизовано (AVX2/AVX-512, выбор во время выполнения - см. simd.h).
+void mask_band_sum(
+ int K, const real_t *H, const int *band,
+ size_t F, const spectrum_t *x, size_t x_step, spectrum_t *sum);
+
+/// Одновременная маскировка одним окном для всех каналов (свертка кадра с окном):
+///  sum[k] = sum_m h[m] * x[k + m], m из [0, Ws).
+/// \a x - кадр спектра, расширенный на Ws/2 отсчетов с каждой стороны.
+/// Векторизовано (см. simd.h).
+void mask_conv_sum(int K, const real_t *h, int Ws, const spectrum_t *x, spectrum_t *sum);
+
+/// Сравнение кадра спектра с суммами маскировки с упаковкой результата:
+///  бит k упакованного кадра \a words равен (x[k] > sum[k]), биты после K - нулевые.
+/// Векторизовано (см. simd.h).
+void mask_compare_pack(int K, const spectrum_t *x, const spectrum_t *sum, mask_word_t *words);
+
+/// Шаг последовательной маскировки по кадру \a x с упаковкой результата:
+///  бит k кадра \a words равен (x[k] > c * E[k]), затем порог E[k] = max(x[k], a * E[k]).
+/// Векторизовано по каналам (см. simd.h).
+void mask_temp_step(int K, real_t a, real_t c, const spectrum_t *x, spectrum_t *E, mask_word_t *words);
+
+//@{
+/// Упаковка кадра маски из K значений mask_t и распаковка обратно.
+void mask_pack(int K, const mask_t *mask, mask_word_t *words);
+void mask_unpack(int K, const mask_word_t *words, mask_t *mask);
+//@}
+
+///
+/// Преобразование потоков маски: упакованные кадры (mask_word_t) <-> mask_t на канал.
+/// Нужны для совместимости: вычислители маскировки и ЧОТ работают с упакованными кадрами,
+///  а прежний интерфейс (mask_t на канал) реализуется через эти обертки.
+///
+
+/// Чтение упакованных кадров из потока mask_t (K значений на кадр).
+class mask_pack_istream : public io::iwrap<mask_word_t, mask_t>
+{
+public:
+    mask_pack_istream(io::istream<mask_t>& str, int K);
+    ~mask_pack_istream();
+
+    bool eos() const override { return _pos >= W && _understream->eos(); }
+    size_t read(mask_word_t *buf, size_t count) override;
+
+private:
+    const int K, W;
+    mask_t *_frame;
+    mask_word_t *_words;
+    int _pos;
+};
+
+/// Запись упакованных кадров в поток mask_t (K значений на кадр).
+class mask_unpack_ostream : public io::owrap<mask_word_t, mask_t>
+{
+public:
+    mask_unpack_ostream(io::ostream<mask_t>& str, int K);
+    ~mask_unpack_ostream();
+
+    size_t write(const mask_word_t *buf, size_t count) override;
+
+    /// Количество значений mask_t, записанных в выходной поток.
+    size_t written() const { return _written; }
+
+private:
+    const int K, W;
+    mask_t *_frame;
+    mask_word_t *_words;
+    int _pos;
+    size_t _written;
+};
+
+/// Запись потока mask_t (K значений на кадр) в поток упакованных кадров.
+class mask_pack_ostream : public io::owrap<mask_t, mask_word_t>
+{
+public:
+    mask_pack_ostream(io::ostream<mask_word_t>& str, int K);
+    ~mask_pack_ostream();
+
+    size_t write(const mask_t *buf, size_t count) override;
+
+    /// Количество слов, записанных в выходной поток.
+    size_t written() const { return _written; }
+
+private:
+    const int K, W;
+    mask_t *_frame;
+    mask_word_t *_words;
+    int _pos;
+    size_t _written;
+};
+
+///
+/// Вычислители одновременной маскировки.
+/// Основной выход - упакованные кадры маски (поток mask_word_t, mask_frame_words(K) слов на кадр);
+///  выход mask_t на канал сохранен для совместимости.
+/// Шаг \a hop (set_hop) прореживает вход во времени: маскируются кадры 0, hop, 2*hop, ...
+///
+
 class freq_mask_calculator :
-    public io::filter<spectrum_t, mask_t>
+    public io::filter<spectrum_t, mask_t>,
+    public io::filter<spectrum_t, mask_word_t>
 {
 public:
     freq_mask_calculator(const char *filepath);
@@ -24,38 +137,147 @@ public:
     bool save(const char *filepath);
 
     size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_t>& mask) const override;
+    size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_word_t>& mask) const override;
+
+    /// Шаг прореживания входных кадров.
+    void set_hop(int h) { hop = h < 1 ? 1 : h; }
+    int hop_size() const { return hop; }
 
 private:
 
     int K, Ws;
-    double *H;
+    int hop = 1;
+    /// Коэффициенты маскировки, транспонированные: H[m * K + k], m из [0, Ws).
+    std::unique_ptr<real_t[], conv_deleter> H;
+    /// Интервалы ненулевых коэффициентов для блоков по MASK_BAND_BLOCK каналов.
+    std::vector<int> band;
 
     bool init(const freq_scale_t& s, const mask_params_t& p);
 };
 
 class freq_mask_calculator_fast :
-    public io::filter<spectrum_t, mask_t>
+    public io::filter<spectrum_t, mask_t>,
+    public io::filter<spectrum_t, mask_word_t>
 {
 public:
     freq_mask_calculator_fast(const char *filepath);
     freq_mask_calculator_fast(const freq_scale_t& s, double ksi);
-    freq_mask_calculator_fast(const freq_scale_t& s, const mask_params_t& p);
+    /// \a N - размер окна циклической свертки (CONV_SIZ_AUTO - выбирается автоматически 
+    ///  по размеру окна маскировки и ожидаемой длине спектра \a length, см. cconv_choose_size).
+    freq_mask_calculator_fast(const freq_scale_t& s, const mask_params_t& p, 
+        int N = CONV_SIZ_AUTO, size_t length = 0);
     ~freq_mask_calculator_fast();
 
     /// Сохранить коэффициенты в файл.
     bool save(const char *filepath);
 
     size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_t>& mask) const override;
+    /// Блоки свертки не совпадают с кадрами, поэтому решения упаковываются по кадрам при выводе.
+    size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_word_t>& mask) const override;
+
+    /// Шаг прореживания входных кадров.
+    void set_hop(int h) { hop = h < 1 ? 1 : h; }
+    int hop_size() const { return hop; }
+
+    /// Размер окна циклической свертки.
+    int block_size() const { return N; }
+
+private:
+    int K, Ws, N;
+    int hop = 1;
+    std::unique_ptr<real_t[], conv_deleter> H;
+
+    bool init(const freq_scale_t& s, const mask_params_t& p, size_t length);
+};
+
+/// Одновременная маскировка по кадрам для шкал с одинаковой формой окна маскировки (модельная шкала).
+///
+/// В отличие от freq_mask_calculator_fast, не собирает кадры в блоки свертки:
+///  каждый кадр из K отсчетов маскируется и выводится сразу, задержка - один кадр.
+/// Окно маскировки одно для всех каналов, свертка с ним - короткая прямая 
+///  (векторное ядро mask_conv_sum(), Wt умножений на канал).
+/// Допуск \a tolerance (по умолчанию - mask_params_t::ksi) задает, какие края окна
+///  отбрасываются: коэффициенты меньше tolerance * max(окна).
+class freq_mask_calculator_frame :
+    public io::filter<spectrum_t, mask_t>,
+    public io::filter<spectrum_t, mask_word_t>
+{
+public:
+    /// \a tolerance < 0 - допуск равен \a p.ksi.
+    freq_mask_calculator_frame(const freq_scale_t& s, const mask_params_t& p, double tolerance = -1);
+    ~freq_mask_calculator_frame();
+
+    size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_t>& mask) const override;
+    size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_word_t>& mask) const override;
+
+    /// Шаг прореживания входных кадров.
+    void set_hop(int h) { hop = h < 1 ? 1 : h; }
+    int hop_size() const { return hop; }
+
+    /// Ширина окна после отбрасывания краев.
+    int window_size() const { return Wt; }
 
 private:
     int K, Ws;
-    double *H;
+    int hop = 1;
+    /// Окно маскировки (Ws коэффициентов), используемая часть - [m0, m0 + Wt).
+    std::unique_ptr<real_t[], conv_deleter> h;
+    int m0, Wt;
+};
 
-    bool init(const freq_scale_t& s, const mask_params_t& p);
+///
+/// Последовательная (временная) маскировка.
+///
+/// Маскирующий порог канала после маскера спадает экспоненциально:
+///  E_k(t) = max(x_k(t), a * E_k(t-1)), a = exp(-1 / (tau * F)), где F - частота кадров.
+/// Отсчет не замаскирован, если он больше порога, оставленного предыдущими кадрами:
+///  x_k(t) > rho * a * E_k(t-1).
+/// Состояние - один кадр порогов, память не зависит от длины сигнала.
+///
+/// Совмещение с одновременной маскировкой: если задан вычислитель \a freq, 
+///  отсчет не замаскирован, только если он не замаскирован обоими способами.
+/// Спектр при этом читается один раз: последовательная маска вычисляется по мере чтения
+///  кадров вычислителем \a freq и накладывается на его выход; в очереди хранятся только
+///  прочитанные, но еще не выведенные им кадры (не больше его блока).
+/// Шаг \a hop (set_hop) должен совпадать с шагом вычислителя \a freq: порог обновляется
+///  по всем кадрам, а выводятся (и накладываются на его выход) кадры 0, hop, 2*hop, ...
+/// Если кадру вычислителя \a freq не нашлось кадра последовательной маски или после чтения
+///  всего спектра в очереди остались лишние кадры, шаги не совпадают - бросается исключение.
+///
+class temp_mask_calculator :
+    public io::filter<spectrum_t, mask_t>,
+    public io::filter<spectrum_t, mask_word_t>
+{
+public:
+    /// \a F - частота кадров спектра (частота дискретизации, деленная на шаг кадров).
+    temp_mask_calculator(const freq_scale_t& s, freq_t F, const temp_mask_params_t& p,
+        const io::filter<spectrum_t, mask_word_t> *freq = 0);
+
+    size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_t>& mask) const override;
+    size_t execute(io::istream<spectrum_t>& spectrum, io::ostream<mask_word_t>& mask) const override;
+
+    /// Коэффициент спада порога за кадр.
+    real_t decay() const { return a; }
+
+    /// Шаг прореживания выходных кадров.
+    void set_hop(int h) { hop = h < 1 ? 1 : h; }
+    int hop_size() const { return hop; }
+
+private:
+    int K;
+    int hop = 1;
+    real_t a, rho;
+    const io::filter<spectrum_t, mask_word_t> *freq;
 };
 
 size_t mask_memory(const freq_scale_t& scale, size_t N, const spectrum_t *spectrum, mask_t *mask, const mask_params_t& p);
 
+/// Одновременная маскировка \a N кадров в памяти с упакованным выходом:
+///  \a mask - N * mask_frame_words(K) слов. Возвращает количество записанных слов.
+/// Вычислитель тот же, что и для mask_t, поэтому маски совпадают;
+///  freq_mask_calculator_frame (окно с отброшенными краями) используется только явно.
+size_t mask_memory(const freq_scale_t& scale, size_t N, const spectrum_t *spectrum, mask_word_t *mask, const mask_params_t& p);
+
 NAMESPACE_SPL_END;
 
 #endif//_SPL_MASK_
@@ -0,0 +1,235 @@
+///
+/// \file  mask_simd.cpp
+/// \brief Векторные ядра одновременной маскировки (прямой алгоритм)
+///
+/// Маскировка на шкале произвольной формы - умножение ленточной матрицы K x K
+///  (ширина ленты Ws) на кадр спектра. Коэффициенты хранятся транспонированными
+///  (H[m * K + k]), поэтому для каждого смещения m вклад во все каналы k
+///  считается непрерывными векторными операциями.
+/// Несколько кадров обрабатываются за один проход по коэффициентам:
+///  строка коэффициентов загружается один раз и используется для всех кадров.
+///
+/// Для шкал с одинаковым окном во всех каналах (модельная шкала) есть отдельное ядро - 
+///  свертка одного кадра с одним окном (mask_conv_sum).
+///
+/// Результат маскировки упаковывается в биты сразу при сравнении (mask_compare_pack):
+///  векторное сравнение дает маску из W бит, которая вставляется в слово кадра.
+///
+/// Последовательная маскировка (mask_temp_step) - рекурсия по времени независимо 
+///  в каждом канале, поэтому шаг по кадру векторизуется по каналам.
+///
+
+#include "mask.h"
+#include "simd_ops.h"
+using spl::real_t;
+using spl::spectrum_t;
+using spl::MASK_BAND_BLOCK;
+using spl::mask_word_t;
+using spl::MASK_WORD_BITS;
+
+#include <algorithm>
+
+namespace {
+
+/// Скалярный вариант для каналов [k0, k1) блока с лентой [m0, m1).
+/// Порядок суммирования - по возрастанию m, как в наивном алгоритме.
+void band_scalar(
+ int K, int k0, int k1, int m0, int m1, const real_t *H,
+ size_t F, const spectrum_t *x, size_t x_step, spectrum_t *sum)
+{
+  for(size_t f = 0; f < F; f++) {
+    const spectrum_t *xf = x + f * x_step;
+    spectrum_t *sf = sum + f * K;
+    for(int k = k0; k < k1; k++) {
+      spectrum_t s = 0;
+      for(int m = m0; m < m1; m++)
+        s += xf[k + m] * H[m * K + k];
+      sf[k] = s;
+    }
+  }
+}
+
+void mask_band_scalar(
+ int K, const real_t *H, const int *band,
+ size_t F, const spectrum_t *x, size_t x_step, spectrum_t *sum)
+{
+  for(int k0 = 0, b = 0; k0 < K; k0 += MASK_BAND_BLOCK, b++)
+    band_scalar(K, k0, std::min(k0 + MASK_BAND_BLOCK, K), band[2*b], band[2*b+1], H, F, x, x_step, sum);
+}
+
+void conv_scalar(int k0, int K, const real_t *h, int Ws, const spectrum_t *x, spectrum_t *sum) {
+  for(int k = k0; k < K; k++) {
+    spectrum_t s = 0;
+    for(int m = 0; m < Ws; m++)
+      s += x[k + m] * h[m];
+    sum[k] = s;
+  }
+}
+
+void compare_scalar(int k0, int K, const spectrum_t *x, const spectrum_t *sum, mask_word_t *words) {
+  for(int k = k0; k < K; k++) {
+    if(x[k] > sum[k])
+      words[k / MASK_WORD_BITS] |= mask_word_t(1) << (k % MASK_WORD_BITS);
+  }
+}
+
+void temp_scalar(int k0, int K, real_t a, real_t c, const spectrum_t *x, spectrum_t *E, mask_word_t *words) {
+  for(int k = k0; k < K; k++) {
+    if(x[k] > c * E[k])
+      words[k / MASK_WORD_BITS] |= mask_word_t(1) << (k % MASK_WORD_BITS);
+    E[k] = std::max(x[k], a * E[k]);
+  }
+}
+
+#ifdef SPL_SIMD_X86
+
+/// Ядро для набора инструкций V с атрибутом TARGET (см. SPL_CONV_KERNELS в conv_simd.cpp).
+/// NF кадров считаются одновременно: NF аккумуляторов на W каналов остаются в регистрах.
+#define SPL_MASK_KERNEL(V, TARGET, suffix)                                               \
+template<int NF>                                                                         \
+TARGET void band_##suffix(                                                               \
+ int K, int k0, int k1, int m0, int m1, const real_t *H,                                 \
+ const spectrum_t *x, size_t x_step, spectrum_t *sum)                                    \
+{                                                                                        \
+  typedef V::vec vec;                                                                    \
+  int k = k0;                                                                            \
+  for(; k + V::W <= k1; k += V::W) {                                                     \
+    vec acc[NF];                                                                         \
+    for(int f = 0; f < NF; f++) acc[f] = V::zero();                                      \
+    for(int m = m0; m < m1; m++) {                                                       \
+      const vec h = V::load(H + m * K + k);                                              \
+      for(int f = 0; f < NF; f++)                                                        \
+        acc[f] = V::fmadd(h, V::load(x + f * x_step + k + m), acc[f]);                   \
+    }                                                                                    \
+    for(int f = 0; f < NF; f++) V::store(sum + f * K + k, acc[f]);                       \
+  }                                                                                      \
+  band_scalar(K, k, k1, m0, m1, H, NF, x, x_step, sum);                                  \
+}                                                                                        \
+                                                                                         \
+TARGET void mask_band_##suffix(                                                          \
+ int K, const real_t *H, const int *band,                                                \
+ size_t F, const spectrum_t *x, size_t x_step, spectrum_t *sum)                          \
+{                                                                                        \
+  for(int k0 = 0, b = 0; k0 < K; k0 += MASK_BAND_BLOCK, b++) {                           \
+    const int k1 = std::min(k0 + MASK_BAND_BLOCK, K);                                    \
+    const int m0 = band[2*b], m1 = band[2*b+1];                                          \
+    size_t f = 0;                                                                        \
+    for(; f + 4 <= F; f += 4)                                                            \
+      band_##suffix<4>(K, k0, k1, m0, m1, H, x + f * x_step, x_step, sum + f * K);       \
+    for(; f < F; f++)                                                                    \
+      band_##suffix<1>(K, k0, k1, m0, m1, H, x + f * x_step, x_step, sum + f * K);       \
+  }                                                                                      \
+}
+
+/// Свертка кадра с одним окном: коэффициент окна размножается на весь регистр.
+#define SPL_MASK_CONV_KERNEL(V, TARGET, suffix)                                          \
+TARGET void mask_conv_##suffix(int K, const real_t *h, int Ws, const spectrum_t *x, spectrum_t *sum) \
+{                                                                                        \
+  typedef V::vec vec;                                                                    \
+  int k = 0;                                                                             \
+  for(; k + V::W <= K; k += V::W) {                                                      \
+    vec acc = V::zero();                                                                 \
+    for(int m = 0; m < Ws; m++)                                                          \
+      acc = V::fmadd(V::set1(h[m]), V::load(x + k + m), acc);                            \
+    V::store(sum + k, acc);                                                              \
+  }                                                                                      \
+  conv_scalar(k, K, h, Ws, x, sum);                                                      \
+}
+
+/// Сравнение с упаковкой: W делит MASK_WORD_BITS, поэтому маска регистра
+///  целиком попадает в одно слово.
+#define SPL_MASK_COMPARE_KERNEL(V, TARGET, suffix)                                       \
+TARGET void compare_##suffix(int K, const spectrum_t *x, const spectrum_t *sum, mask_word_t *words) \
+{                                                                                        \
+  int k = 0;                                                                             \
+  for(; k + V::W <= K; k += V::W) {                                                      \
+    const mask_word_t m = V::gt(V::load(x + k), V::load(sum + k));                       \
+    words[k / MASK_WORD_BITS] |= m << (k % MASK_WORD_BITS);                              \
+  }                                                                                      \
+  compare_scalar(k, K, x, sum, words);                                                   \
+}
+
+/// Шаг последовательной маскировки: сравнение с порогом, упаковка, обновление порога.
+#define SPL_MASK_TEMP_KERNEL(V, TARGET, suffix)                                          \
+TARGET void temp_##suffix(int K, real_t a, real_t c, const spectrum_t *x, spectrum_t *E, mask_word_t *words) \
+{                                                                                        \
+  typedef V::vec vec;                                                                    \
+  const vec va = V::set1(a), vc = V::set1(c);                                            \
+  int k = 0;                                                                             \
+  for(; k + V::W <= K; k += V::W) {                                                      \
+    const vec xk = V::load(x + k), e = V::load(E + k);                                   \
+    const mask_word_t m = V::gt(xk, V::mul(vc, e));                                      \
+    words[k / MASK_WORD_BITS] |= m << (k % MASK_WORD_BITS);                              \
+    V::store(E + k, V::max(xk, V::mul(va, e)));                                          \
+  }                                                                                      \
+  temp_scalar(k, K, a, c, x, E, words);                                                  \
+}
+
+SPL_MASK_KERNEL(spl::avx2_t, SPL_TARGET_AVX2, avx2)
+SPL_MASK_KERNEL(spl::avx512_t, SPL_TARGET_AVX512, avx512)
+SPL_MASK_CONV_KERNEL(spl::avx2_t, SPL_TARGET_AVX2, avx2)
+SPL_MASK_CONV_KERNEL(spl::avx512_t, SPL_TARGET_AVX512, avx512)
+SPL_MASK_COMPARE_KERNEL(spl::avx2_t, SPL_TARGET_AVX2, avx2)
+SPL_MASK_COMPARE_KERNEL(spl::avx512_t, SPL_TARGET_AVX512, avx512)
+SPL_MASK_TEMP_KERNEL(spl::avx2_t, SPL_TARGET_AVX2, avx2)
+SPL_MASK_TEMP_KERNEL(spl::avx512_t, SPL_TARGET_AVX512, avx512)
+
+#endif
+
+}
+
+NAMESPACE_SPL_BEGIN;
+
+void mask_band_sum(
+ int K, const real_t *H, const int *band,
+ size_t F, const spectrum_t *x, size_t x_step, spectrum_t *sum)
+{
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512: mask_band_avx512(K, H, band, F, x, x_step, sum); return;
+  case simd_avx2:   mask_band_avx2(K, H, band, F, x, x_step, sum); return;
+  default: break;
+  }
+#endif
+  mask_band_scalar(K, H, band, F, x, x_step, sum);
+}
+
+void mask_conv_sum(int K, const real_t *h, int Ws, const spectrum_t *x, spectrum_t *sum)
+{
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512: mask_conv_avx512(K, h, Ws, x, sum); return;
+  case simd_avx2:   mask_conv_avx2(K, h, Ws, x, sum); return;
+  default: break;
+  }
+#endif
+  conv_scalar(0, K, h, Ws, x, sum);
+}
+
+void mask_compare_pack(int K, const spectrum_t *x, const spectrum_t *sum, mask_word_t *words)
+{
+  std::fill_n(words, mask_frame_words(K), 0);
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512: compare_avx512(K, x, sum, words); return;
+  case simd_avx2:   compare_avx2(K, x, sum, words); return;
+  default: break;
+  }
+#endif
+  compare_scalar(0, K, x, sum, words);
+}
+
+void mask_temp_step(int K, real_t a, real_t c, const spectrum_t *x, spectrum_t *E, mask_word_t *words)
+{
+  std::fill_n(words, mask_frame_words(K), 0);
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512: temp_avx512(K, a, c, x, E, words); return;
+  case simd_avx2:   temp_avx2(K, a, c, x, E, words); return;
+  default: break;
+  }
+#endif
+  temp_scalar(0, K, a, c, x, E, words);
+}
+
+NAMESPACE_SPL_END;
@@ -12,25 +12,7 @@
 
 #include "common.h" // size_t
 
-#include <stdarg.h>
-
-/// Макрос для использования произвольного количества аргументов в функции.
-/// Копирует аргументы в заранее заданный массив "name".
-#define va2array(T, name, first, D) \
-  va_list vl; \
-  va_start(vl, first); \
-  name[0] = first; \
-  for(int i = 1; i < D; i++) { \
-   name[i] = va_arg(vl, T); \
-  } \
-  va_end(vl);
-
-/// Макрос для использования произвольного количества аргументов в функции.
-/// Задает массив "name" и копирует в него аргументы.
-#define va2array2(T, name, first, D) \
-	T name[D]; \
-	va2array(T, name, first, D)
-
+#include <string.h> // memcpy
 
 
 /// Вспомогательная функция расчета линейного индекса матрицы.
@@ -57,13 +39,18 @@ public:
     _data(data), _size(dim2siz(D, dims))
   {
     memcpy(_dim, dims, sizeof(size_t) * D);
+    init_strides();
   }
-  /// Конструктор (принимает размерности в списке аргументов).
-  Matrix(T *data, size_t first, ...): 
+  /// Конструктор (принимает ровно D размерностей в списке аргументов).
+  template<typename... I>
+  Matrix(T *data, size_t first, I... rest): 
     _data(data)
   {
-  	va2array(size_t, _dim, first, D);
+    static_assert(sizeof...(I) + 1 == D, "Matrix: number of dimensions must be equal to D");
+    const size_t dims[D] = { first, size_t(rest)... };
+    memcpy(_dim, dims, sizeof(size_t) * D);
     _size = dim2siz(D, _dim);
+    init_strides();
   }
   
   //@{
@@ -71,19 +58,20 @@ public:
   /// matrix(1,2) возвратит элемент, который располагается в первой строке, втором столбце.
   /// При этом матрица должна быть двумерной.
   /// 
-  /// Внимание: размерность матрицы не проверяется! 
-  /// (Ее невозможно проверить в такой абстрактной реализации класса матрицы).
-  /// Если матрица является D-мерной, то в эту функцию должно быть передано ровно D аргументов типа size_t.
-  /// Если будет передано больше аргументов, то в расчет будут приняты только первые D аргументов.
-  /// Если будет передано меньше аргументов, то вероятно возникнет ошибка обращения к памяти.
-  const T& operator()(size_t first, ...) const { 
-    va2array2(size_t, sub, first, D);
-    return _data[sub2ind(sub)]; 
+  /// Количество индексов проверяется при компиляции: их должно быть ровно D.
+  /// Шаги по измерениям рассчитываются один раз в конструкторе, 
+  ///  поэтому обращение сводится к D-1 умножениям и сложениям.
+  /// Выход индексов за границы не проверяется.
+  template<typename... I>
+  const T& operator()(size_t first, I... rest) const { 
+    static_assert(sizeof...(I) + 1 == D, "Matrix: number of indices must be equal to D");
+    return _data[offset(first, size_t(rest)...)]; 
   }
 
-  T& operator()(size_t first, ...) { 
-    va2array2(size_t, sub, first, D);
-    return _data[sub2ind(sub)]; 
+  template<typename... I>
+  T& operator()(size_t first, I... rest) { 
+    static_assert(sizeof...(I) + 1 == D, "Matrix: number of indices must be equal to D");
+    return _data[offset(first, size_t(rest)...)]; 
   }
   //@}
 
@@ -120,16 +108,31 @@ private:
   /// Собственно данные матрицы. Должны иметь размер _dim[0] * _dim[1] * ...
   T *_data;
 
-  /// Расчет линейного индекса
-  size_t sub2ind(size_t sub[]) const {
-    switch(D) { // для оптимизации (возможно компилятор уберет ненужные ветки)
-    case 1: return sub[0];
-    case 2: return _dim[1] * sub[0] + sub[1];
-    case 3: return _dim[2] * (_dim[1] * sub[0] + sub[1]) + sub[2];
-    default: return ::sub2ind(D, _dim, sub);
+  /// Шаги по измерениям (кроме последнего, шаг которого равен 1).
+  /// _stride[d] = _dim[d+1] * ... * _dim[D-1]
+  size_t _stride[D > 1 ? D - 1 : 1];
+
+  void init_strides() {
+    size_t stride = 1;
+    for(int d = D - 1; d > 0; d--) {
+      stride *= _dim[d];
+      _stride[d - 1] = stride;
     }
   }
 
+  //@{
+  /// Расчет линейного индекса.
+  /// Номер измерения определяется количеством оставшихся индексов - при компиляции.
+  size_t offset(size_t last) const { 
+    return last; 
+  }
+
+  template<typename... I>
+  size_t offset(size_t first, I... rest) const {
+    return first * _stride[D - 1 - sizeof...(I)] + offset(rest...);
+  }
+  //@}
+
 };
 
 /// Функция для быстрого получения двумерной матрицы.
@@ -166,9 +169,10 @@ Matrix<T,D2> reshape(Matrix<T,D1>& mtx1, const size_t dims2[]) {
   return Matrix<T,D2>(mtx1.ptr(), dims2);
 }
 
-template<typename T, int D1, int D2>
-Matrix<T,D2> reshape(Matrix<T,D1>& mtx1, const size_t first, ...) {
-  va2array2(size_t, dims, first, D2);
+template<typename T, int D1, int D2, typename... I>
+Matrix<T,D2> reshape(Matrix<T,D1>& mtx1, size_t first, I... rest) {
+  static_assert(sizeof...(I) + 1 == D2, "reshape: number of dimensions must be equal to D2");
+  const size_t dims[D2] = { first, size_t(rest)... };
   return reshape<T,D1,D2>(mtx1, dims);
 }
 //@}
@@ -0,0 +1,120 @@
+///
+/// \file  simd.cpp
+/// \brief Определение возможностей процессора.
+///
+
+#include "simd.h"
+
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+NAMESPACE_SPL_BEGIN;
+
+namespace {
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+
+void cpuid(int leaf, int subleaf, unsigned r[4]) {
+#if defined(_MSC_VER)
+    __cpuidex((int *)r, leaf, subleaf);
+#else
+    __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+unsigned long long xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+simd_level_t detect() {
+    unsigned r[4];
+    cpuid(0, 0, r);
+    const unsigned max_leaf = r[0];
+    if (max_leaf < 7) return simd_scalar;
+
+    cpuid(1, 0, r);
+    const bool osxsave = (r[2] >> 27) & 1;
+    const bool avx = (r[2] >> 28) & 1;
+    const bool fma = (r[2] >> 12) & 1;
+    if (!osxsave || !avx || !fma) return simd_scalar;
+
+    // ОС должна сохранять регистры YMM (и ZMM для AVX-512) при переключении контекста
+    const unsigned long long xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) return simd_scalar;
+
+    cpuid(7, 0, r);
+    const bool avx2 = (r[1] >> 5) & 1;
+    const bool avx512f = (r[1] >> 16) & 1;
+    const bool avx512bw = (r[1] >> 30) & 1;
+    const bool avx512vl = (r[1] >> 31) & 1;
+    if (!avx2) return simd_scalar;
+
+    if (avx512f && avx512bw && avx512vl && (xcr0 & 0xE0) == 0xE0)
+        return simd_avx512;
+    return simd_avx2;
+}
+
+bool detect_vpopcnt() {
+    if (detect() != simd_avx512) return false;
+    unsigned r[4];
+    cpuid(7, 0, r);
+    return (r[2] >> 14) & 1;
+}
+
+#else
+
+simd_level_t detect() { return simd_scalar; }
+bool detect_vpopcnt() { return false; }
+
+#endif
+
+std::atomic<int> current_level(-1);
+
+}
+
+simd_level_t simd_supported() {
+    static const simd_level_t supported = detect();
+    return supported;
+}
+
+bool simd_avx512_vpopcnt() {
+    static const bool supported = detect_vpopcnt();
+    return supported;
+}
+
+simd_level_t simd_level() {
+    int level = current_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = simd_supported();
+        current_level.store(level, std::memory_order_relaxed);
+    }
+    return simd_level_t(level);
+}
+
+simd_level_t simd_set_level(simd_level_t level) {
+    if (level > simd_supported())
+        level = simd_supported();
+    current_level.store(level, std::memory_order_relaxed);
+    return level;
+}
+
+const char *simd_level_name(simd_level_t level) {
+    switch (level) {
+    case simd_avx2:   return "avx2";
+    case simd_avx512: return "avx512";
+    default:          return "scalar";
+    }
+}
+
+NAMESPACE_SPL_END;
@@ -0,0 +1,58 @@
+#ifndef _SPL_SIMD_
+#define _SPL_SIMD_
+
+///
+/// \file  simd.h
+/// \brief Выбор набора SIMD-инструкций во время выполнения.
+///
+/// Вычислительные ядра (свертка, маскировка и т.п.) компилируются в нескольких вариантах:
+///  скалярном (переносимом) и векторных (AVX2, AVX-512).
+/// Нужный вариант выбирается при первом вызове по возможностям процессора;
+///  для тестов и замеров уровень можно понизить вручную.
+///
+
+#include "common.h"
+
+/// Атрибуты функций, использующих расширенные наборы инструкций.
+/// MSVC разрешает интринсики любых наборов без специальных флагов,
+///  GCC и Clang требуют указания целевого набора для каждой функции.
+#if defined(_MSC_VER) && !defined(__clang__)
+#   define SPL_TARGET_AVX2
+#   define SPL_TARGET_AVX512
+#   define SPL_TARGET_AVX512_VPOPCNT
+#else
+#   define SPL_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#   define SPL_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,fma")))
+#   define SPL_TARGET_AVX512_VPOPCNT \
+        __attribute__((target("avx512f,avx512bw,avx512vl,avx512vpopcntdq,avx2,fma")))
+#endif
+
+NAMESPACE_SPL_BEGIN;
+
+/// Уровень поддержки SIMD-инструкций.
+enum simd_level_t {
+    simd_scalar = 0, ///< без явной векторизации
+    simd_avx2,       ///< AVX2 + FMA
+    simd_avx512,     ///< AVX-512 (F, BW, VL)
+};
+
+/// Максимальный уровень, поддерживаемый процессором и операционной системой.
+simd_level_t simd_supported();
+
+/// Поддержка векторного подсчета бит AVX-512 VPOPCNTDQ.
+/// Используется ядрами только на уровне simd_avx512.
+bool simd_avx512_vpopcnt();
+
+/// Текущий уровень, используемый вычислительными ядрами.
+simd_level_t simd_level();
+
+/// Установка уровня (не выше поддерживаемого). Возвращает установленный уровень.
+/// Предназначена для тестов и замеров; не должна вызываться во время вычислений.
+simd_level_t simd_set_level(simd_level_t level);
+
+/// Название уровня - для отчетов.
+const char *simd_level_name(simd_level_t level);
+
+NAMESPACE_SPL_END;
+
+#endif//_SPL_SIMD_
@@ -0,0 +1,94 @@
+#ifndef _SPL_SIMD_OPS_
+#define _SPL_SIMD_OPS_
+
+///
+/// \file  simd_ops.h
+/// \brief Операции над векторными регистрами для ядер с выбором набора инструкций.
+///
+/// Внутренний заголовок модулей *_simd.cpp.
+/// Структуры avx2_t и avx512_t задают тип регистра и операции над числами real_t;
+///  ядра пишутся один раз и инстанцируются для каждого набора инструкций.
+/// Определен только для x86 (SPL_SIMD_X86), иначе используются скалярные варианты.
+///
+
+#include "spl_types.h"
+#include "simd.h"
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+#define SPL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef SPL_SIMD_X86
+
+NAMESPACE_SPL_BEGIN;
+
+#ifdef SPL_FLOAT
+
+struct avx2_t {
+  typedef __m256 vec;
+  enum { W = 8 };
+  static SPL_TARGET_AVX2 vec zero() { return _mm256_setzero_ps(); }
+  static SPL_TARGET_AVX2 vec set1(real_t x) { return _mm256_set1_ps(x); }
+  static SPL_TARGET_AVX2 vec load(const real_t *p) { return _mm256_loadu_ps(p); }
+  static SPL_TARGET_AVX2 void store(real_t *p, vec x) { _mm256_storeu_ps(p, x); }
+  static SPL_TARGET_AVX2 vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+  static SPL_TARGET_AVX2 vec max(vec a, vec b) { return _mm256_max_ps(a, b); }
+  static SPL_TARGET_AVX2 vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_ps(a, b, c); }
+  static SPL_TARGET_AVX2 vec fmsub(vec a, vec b, vec c) { return _mm256_fmsub_ps(a, b, c); }
+  /// Маска сравнения a > b: бит i - результат для элемента i.
+  static SPL_TARGET_AVX2 unsigned gt(vec a, vec b) { return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ))); }
+};
+
+struct avx512_t {
+  typedef __m512 vec;
+  enum { W = 16 };
+  static SPL_TARGET_AVX512 vec zero() { return _mm512_setzero_ps(); }
+  static SPL_TARGET_AVX512 vec set1(real_t x) { return _mm512_set1_ps(x); }
+  static SPL_TARGET_AVX512 vec load(const real_t *p) { return _mm512_loadu_ps(p); }
+  static SPL_TARGET_AVX512 void store(real_t *p, vec x) { _mm512_storeu_ps(p, x); }
+  static SPL_TARGET_AVX512 vec mul(vec a, vec b) { return _mm512_mul_ps(a, b); }
+  static SPL_TARGET_AVX512 vec max(vec a, vec b) { return _mm512_max_ps(a, b); }
+  static SPL_TARGET_AVX512 vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_ps(a, b, c); }
+  static SPL_TARGET_AVX512 vec fmsub(vec a, vec b, vec c) { return _mm512_fmsub_ps(a, b, c); }
+  static SPL_TARGET_AVX512 unsigned gt(vec a, vec b) { return unsigned(_mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)); }
+};
+
+#else
+
+struct avx2_t {
+  typedef __m256d vec;
+  enum { W = 4 };
+  static SPL_TARGET_AVX2 vec zero() { return _mm256_setzero_pd(); }
+  static SPL_TARGET_AVX2 vec set1(real_t x) { return _mm256_set1_pd(x); }
+  static SPL_TARGET_AVX2 vec load(const real_t *p) { return _mm256_loadu_pd(p); }
+  static SPL_TARGET_AVX2 void store(real_t *p, vec x) { _mm256_storeu_pd(p, x); }
+  static SPL_TARGET_AVX2 vec mul(vec a, vec b) { return _mm256_mul_pd(a, b); }
+  static SPL_TARGET_AVX2 vec max(vec a, vec b) { return _mm256_max_pd(a, b); }
+  static SPL_TARGET_AVX2 vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_pd(a, b, c); }
+  static SPL_TARGET_AVX2 vec fmsub(vec a, vec b, vec c) { return _mm256_fmsub_pd(a, b, c); }
+  /// Маска сравнения a > b: бит i - результат для элемента i.
+  static SPL_TARGET_AVX2 unsigned gt(vec a, vec b) { return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ))); }
+};
+
+struct avx512_t {
+  typedef __m512d vec;
+  enum { W = 8 };
+  static SPL_TARGET_AVX512 vec zero() { return _mm512_setzero_pd(); }
+  static SPL_TARGET_AVX512 vec set1(real_t x) { return _mm512_set1_pd(x); }
+  static SPL_TARGET_AVX512 vec load(const real_t *p) { return _mm512_loadu_pd(p); }
+  static SPL_TARGET_AVX512 void store(real_t *p, vec x) { _mm512_storeu_pd(p, x); }
+  static SPL_TARGET_AVX512 vec mul(vec a, vec b) { return _mm512_mul_pd(a, b); }
+  static SPL_TARGET_AVX512 vec max(vec a, vec b) { return _mm512_max_pd(a, b); }
+  static SPL_TARGET_AVX512 vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_pd(a, b, c); }
+  static SPL_TARGET_AVX512 vec fmsub(vec a, vec b, vec c) { return _mm512_fmsub_pd(a, b, c); }
+  static SPL_TARGET_AVX512 unsigned gt(vec a, vec b) { return unsigned(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ)); }
+};
+
+#endif
+
+NAMESPACE_SPL_END;
+
+#endif//SPL_SIMD_X86
+
+#endif//_SPL_SIMD_OPS_
@@ -19,6 +19,7 @@
 #define _USE_MATH_DEFINES // M_PI, etc
 #include <math.h>
 #include <algorithm>
+#include <vector>
 
 #define _SCL_SECURE_NO_WARNINGS
 
@@ -80,18 +81,16 @@ private:
 
 /// 
 /// Генерация коэффициентов фильтрации по шкале резонансных частот фильтров.
-/// В структуре фильтров \a f уже должно быть выделено место для помещения коэффициентов фильтрации.
+/// Размер окна свертки \a N выбирается здесь же, если он не задан (CONV_SIZ_AUTO), 
+///  после чего выделяется место для коэффициентов фильтрации.
 /// 
 
 bool spectrum_calculator::init(
 	const freq_scale_t& s,        ///< шкала резонансных частот фильтров
     freq_t F,                     ///< частота дискретизации сигнала
-    double ksi                    ///< допустимая ошибка вычислений (определяет размер окна фильтров)
+    double ksi,                   ///< допустимая ошибка вычислений (определяет размер окна фильтров)
+    size_t length                 ///< ожидаемая длина сигнала (0 - неизвестна)
 ) {
-	double array[CONV_WIN_SIZ * 2 + 2];
-	double *Hc = SPL_MEMORY_ALIGN(array);
-	double *Hs = Hc + CONV_WIN_SIZ;
-
 	if(K != s.size()) return false;
 
 	// вычисляем Ws - размер реального окна фильтров
@@ -103,9 +102,39 @@ bool spectrum_calculator::init(
 		if(Wsk > Ws) Ws = Wsk; // на каком канале это произошло, нам даже не важно
 	}
 	this->Ws = 2*Ws+1;
+
+	// размер окна свертки: полезный выход блока (N - Ws) должен быть положительным
+	if(N == CONV_SIZ_AUTO)
+		N = cconv_choose_size(this->Ws, length, K);
+	if(N <= this->Ws)
+		return false;
+
+	// прямая свертка выгоднее FFT, если на кадр выхода приходится меньше операций:
+	//  прямая - 2 x Ws умножений на канал и кадр, FFT - два обратных преобразования 
+	//  (около 2.5 N log N) на канал и блок из (N - Ws + 1) отсчетов
+	if(hop > 1) {
+		const double direct_cost = 4.0 * this->Ws / hop;
+		const double fft_cost = 5.0 * N * log((double)N) / log(2.0) / (N - this->Ws + 1);
+		if(direct_cost < fft_cost) {
+			Hd.reset(spl_alloc<real_t>(2 * this->Ws * K));
+			if(!Hd)
+				throw "Can't allocate memory for spectrum filters coefficients";
+		}
+	}
+
+	const int step = conv_spec_step(N);
+	H.reset(conv_alloc<real_t>(K * 2 * (2 * step)));
+	if (!H)
+		throw "Can't allocate memory for spectrum filters coefficients";
+
+	std::unique_ptr<real_t[], conv_deleter> Hbuf(conv_alloc<real_t>(2 * N));
+	if (!Hbuf)
+		throw "Can't allocate memory for spectrum filters coefficients";
+	real_t *Hc = Hbuf.get();
+	real_t *Hs = Hc + N;
 	
 	// матрица - для удобного доступа к коэффициентам фильтрации
-	Matrix<double, 3> HM = matrix_ptr(H, 2, K, CONV_WIN_SIZ);
+	Matrix<real_t, 3> HM = matrix_ptr(H.get(), 2, K, 2 * step);
 
 	// вычисляем собственно коэффициенты фильтра
 	// для размера окна Ws
@@ -119,40 +148,54 @@ bool spectrum_calculator::init(
 			Hs[j] = norm * sin(Wf * n); // мнимая часть
             j++;
 		}
+		// коэффициенты прямой свертки - без нормировки FFT
+		if(Hd) {
+			for(int m = 0; m < this->Ws; m++) {
+				Hd[m * K + k] = Hc[m];
+				Hd[(this->Ws + m) * K + k] = Hs[m];
+			}
+		}
 		// заполняем оставшиеся коэффициенты нулями
-		std::fill(Hc + j, Hc + CONV_WIN_SIZ, 0);
-		std::fill(Hs + j, Hs + CONV_WIN_SIZ, 0);
+		std::fill(Hc + j, Hc + N, 0);
+		std::fill(Hs + j, Hs + N, 0);
 		// предварительное вычисление вектора BC
-		cconv_calc_BC(Hc, Hs, &HM(0,k,0), &HM(1,k,0));
+		cconv_calc_BC(Hc, Hs, &HM(0,k,0), &HM(1,k,0), N);
 	}
 	// нормализация коэффициентов фильтрации:
-	cconv_normalize(H, HM.size());
+	cconv_normalize(H.get(), HM.size(), N);
+
+	// рабочая память свертки через FFT
+	if(!Hd) {
+		conv.reset(new cconv_batch(K, N));
+		conv_in.reset(conv_alloc<real_t>(3 * N + 2));
+		out_buf.reset(spl_alloc<spectrum_t>(K * (N - this->Ws + 1)));
+		if(!conv_in || !out_buf)
+			throw "Can't allocate memory for spectrum calculation";
+	}
 	return true;
 }
 
-spectrum_calculator::spectrum_calculator(const freq_scale_t& s, freq_t F, double ksi)
+spectrum_calculator::spectrum_calculator(const freq_scale_t& s, freq_t F, double ksi, int N, size_t length, int hop) :
+    K(s.size()), Ws(0), N(N), hop(hop < 1 ? 1 : hop)
 {
-    K = s.size();
-    H = conv_alloc<double>(K * 2 * CONV_WIN_SIZ);
-    if (H == 0)
-        throw "Can't allocate memory for spectrum filters coefficients";
-    if (!init(s, F, ksi))
+    if (!init(s, F, ksi, length))
         throw "Error while generating spectrum filters";
 }
 
 spectrum_calculator::~spectrum_calculator() {
-    conv_free(H);
 }
 
 bool spectrum_calculator::save(const char *file) {
-    return array_to_file(H, K * CONV_WIN_SIZ * 2, file);
+    return array_to_file(H.get(), K * (2 * conv_spec_step(N)) * 2, file);
 }
 
 size_t spectrum_calculator::execute(istream<signal_t>& signal, ostream<spectrum_t>& spectrum) const 
 {
+	if(Hd)
+		return execute_direct(signal, spectrum);
+
 	int Ws = this->Ws - 1; // можно брать на 1 меньше, чем окно - результат не меняется
-	int Os = CONV_WIN_SIZ - Ws;
-	spectrum_t *out_buf = NULL;
+	int Os = N - Ws;
 
 	// обеспечиваем отсутствие смещения в начале сигнала
 	iwstream_extend<signal_t> signal_ext(signal, Ws/2);
@@ -160,51 +203,48 @@ size_t spectrum_calculator::execute(istream<signal_t>& signal, ostream<spectrum_
 	// сколько записано - выходная величина
 	size_t written = 0;
 
+	// номер отсчета сигнала, соответствующего началу полезного выхода блока
+	size_t t0 = 0;
+
 	// буфер входного сигнала - состоит из двух частей:
-	// CONV_WIN_SIZ = Ws + Os, 
+	// N = Ws + Os, 
 	// где Ws - Window size - размер реального окна фильтра, 
-	//     CONV_WIN_SIZ - размер вычисляемой циклической свертки
+	//     N - размер вычисляемой циклической свертки
 	//     Os - Output size - размер полезного выхода свертки
 	// также используется как входной буфер свертки
-	double *conv_in_buf = conv_alloc<double>(5 * CONV_WIN_SIZ + 2);
+	real_t *conv_in_buf = conv_in.get();
 
-	// выходной буфер свертки
-	// имеет такую же структуру как и входной буфер (2*Ws+1) + Os
-	// только полезный выход - последние Os элементов - идут на выход
-	double *tmp_buf1 = conv_in_buf + CONV_WIN_SIZ;
-	double *tmp_buf2 = tmp_buf1 + CONV_WIN_SIZ;
-	double *tmp_buf3 = tmp_buf2 + CONV_WIN_SIZ;
-	double *tmp_buf4 = tmp_buf3 + CONV_WIN_SIZ;
+	// буферы вектора A = FFT(a)
+	real_t *tmp_buf1 = conv_in_buf + N;
+	real_t *tmp_buf2 = tmp_buf1 + N;
 
-	// буфер выходного сигнала
-	// матрицы размера K x Os - для помещения результата свертки
-	// и Os x K - для вывода наружу
-	out_buf = spl_alloc<spectrum_t>(2 * K * Os);
+	// пакетная свертка по всем каналам
+	// ее выходные буферы имеют такую же структуру как и входной буфер (2*Ws+1) + Os
+	// только полезный выход - последние Os элементов - идут на выход
+	cconv_batch& conv = *this->conv;
 
-	Matrix<spectrum_t,2> out_mtx1 = matrix_ptr(out_buf, K, Os);
-	Matrix<spectrum_t,2> out_mtx2 = matrix_ptr(out_buf+K*Os, Os, K);
+	// буфер выходного сигнала - матрица Os x K (отсчеты x каналы) для вывода наружу
+	// результат свертки по каналам записывается в нее сразу транспонированным
+	spectrum_t *out_buf = this->out_buf.get();
 
 	// матрица - для удобного доступа к коэффициентам фильтрации
-	Matrix<double, 3> H = matrix_ptr(this->H, 2, K, CONV_WIN_SIZ);
-
-	if(!out_buf) 
-		goto end; 
+	Matrix<real_t, 3> H = matrix_ptr(this->H.get(), 2, K, 2 * conv_spec_step(N));
 
 	//
 	// подготовка структур данных
 	//
 
 	// очищаем последние Ws элементов входного буфера
-	std::fill(conv_in_buf+CONV_WIN_SIZ-Ws, conv_in_buf+CONV_WIN_SIZ-Ws/2, 0);
+	std::fill(conv_in_buf+N-Ws, conv_in_buf+N-Ws/2, 0);
 
 	// обеспечиваем отсутствие смещения в начале сигнала
-	signal_ext.read(conv_in_buf+CONV_WIN_SIZ-Ws/2, Ws/2);
+	signal_ext.read(conv_in_buf+N-Ws/2, Ws/2);
 
 	// основной цикл фильтрации
 	while(!signal_ext.eos() && !spectrum.eos()) {
 
 		// копируем последние Ws элементов сигнала в начало
-		std::copy(conv_in_buf+CONV_WIN_SIZ-Ws, conv_in_buf+CONV_WIN_SIZ, conv_in_buf);
+		std::copy(conv_in_buf+N-Ws, conv_in_buf+N, conv_in_buf);
 
 		// вводим Os новых отсчетов сигнала
 		// этот буфер будет использоваться неизменно для каждого канала
@@ -214,50 +254,113 @@ size_t spectrum_calculator::execute(istream<signal_t>& signal, ostream<spectrum_
 
 		// если считано меньше, чем Os элементов,
 		//  то будет последний виток цикла
-		// очищаем последние отсчеты сигнала, 
-		// и заменяем матрицы на матрицы меньшего размера (K x rOs)
+		// очищаем последние отсчеты сигнала
 		if(rOs != Os) {
-			std::fill(conv_in_buf + Ws + rOs, conv_in_buf + CONV_WIN_SIZ, 0);
-			out_mtx1 = matrix_ptr(out_buf, K, rOs);
-			out_mtx2 = matrix_ptr(out_buf+K*rOs, rOs, K);
+			std::fill(conv_in_buf + Ws + rOs, conv_in_buf + N, 0);
 		}
 
-		spectrum_t *out_ptr = out_mtx1;
+		conv.calc_A(conv_in_buf, tmp_buf1, tmp_buf2);
+
+		// свертка сразу для всех каналов
+		conv.execute(tmp_buf1, tmp_buf2, &H(0,0,0), &H(1,0,0));
+
+		// вычисление модуля комплексных чисел по всем каналам
+		// только из интервала [Ws, Ws+rOs] и запись в выходную матрицу rOs x K
+		// выходы каналов в пакетной свертке отстоят друг от друга на N
+		// при прореживании - только отсчеты, кратные hop: первый из них - j0
+		const size_t j0 = (hop - t0 % hop) % hop;
+		const size_t rows = j0 < rOs ? (rOs - j0 + hop - 1) / hop : 0;
+		t0 += rOs;
+
+		// выводим матрицу rows x K: по возможности она вычисляется прямо в памяти выходного потока,
+		//  частями по целому числу кадров, иначе - в out_buf
+		for(size_t r = 0; r < rows; ) {
+			size_t n = (rows - r) * K;
+			spectrum_t *span = spectrum.acquire_write(out_buf, n, K);
+			const size_t nr = n / K;
+			const size_t j = Ws + j0 + r * hop;
+			complex_abs_split_transposed(K, nr, conv.ab(0) + j, conv.ac(0) + j, N, span, hop);
+			const size_t w = spectrum.commit_write(span, nr * K);
+			written += w;
+			r += nr;
+			if(nr == 0 || w < nr * K) break;
+		}
 
-		cconv_calc_A(conv_in_buf, tmp_buf1, tmp_buf2);
+	}
 
-		// цикл по каналам
-		for(int k = 0; k < K; k++) {
+	// закрываем поток
+	spectrum.close();
 
-			// свертка
-			cconv(tmp_buf1, tmp_buf2, &H(0,k,0), &H(1,k,0), tmp_buf3, tmp_buf4);
+	return written;
+}
 
-			// вычисление модуля комплексных чисел
-			complex_abs_split(rOs, tmp_buf3 + Ws, tmp_buf4 + Ws, tmp_buf4 + Ws);
 
-			// пишем выход в выходную матрицу - только из интервала [Ws, Ws+rOs]
-			out_ptr = std::copy(tmp_buf4 + Ws, tmp_buf4 + Ws + rOs, out_ptr);
+///
+/// Прореженный выход прямой сверткой: для каждого кадра t (кратного hop)
+///  y_k(t) = sum_m x(t + Ws/2 - m) * h_k(m), m = 0..Ws-1, как и у свертки через FFT
+///  (сигнал продолжен нулями с обеих сторон).
+/// Коэффициенты хранятся по отсчетам окна, поэтому внутренний цикл идет по каналам
+///  без зависимостей между итерациями и векторизуется компилятором.
+///
+size_t spectrum_calculator::execute_direct(istream<signal_t>& signal, ostream<spectrum_t>& spectrum) const
+{
+	const int W = this->Ws, half = W / 2;
+	const real_t *Hc = Hd.get(), *Hs = Hc + W * K;
+
+	// буфер сигнала: отсчеты с номера base, сначала - half нулей перед сигналом
+	std::vector<real_t> buf(half, 0);
+	long long base = -half;
+	size_t length = 0;
+	bool ended = false;
+	const size_t chunk = std::max<size_t>(hop, 4096);
+
+	std::vector<spectrum_t> out(K);
+	std::vector<real_t> yc(K), ys(K);
+	size_t written = 0;
 
+	for(long long t = 0; !spectrum.eos(); t += hop) {
+
+		// нужны отсчеты до t + half включительно
+		while(base + (long long)buf.size() <= t + half) {
+			const size_t n = buf.size();
+			if(!ended) {
+				buf.resize(n + chunk);
+				const size_t r = signal.read(&buf[n], chunk);
+				buf.resize(n + r);
+				length += r;
+				ended = r < chunk;
+			} else {
+				// после конца сигнала - нули
+				buf.resize(size_t(t + half - base + 1), 0);
+			}
+		}
+		if(ended && t >= (long long)length) break;
+
+		std::fill(yc.begin(), yc.end(), 0);
+		std::fill(ys.begin(), ys.end(), 0);
+		const real_t *x = &buf[size_t(t - half - base)];
+		for(int m = 0; m < W; m++) {
+			const real_t xm = x[W - 1 - m];
+			const real_t *hc = Hc + m * K, *hs = Hs + m * K;
+			for(int k = 0; k < K; k++) {
+				yc[k] += xm * hc[k];
+				ys[k] += xm * hs[k];
+			}
+		}
+		for(int k = 0; k < K; k++)
+			out[k] = yc[k] * yc[k] + ys[k] * ys[k];
+		written += spectrum.write(out.data(), K);
+
+		// отбрасываем отсчеты, которые больше не понадобятся
+		const long long keep_from = t + hop - half;
+		if(keep_from - base >= (long long)chunk) {
+			buf.erase(buf.begin(), buf.begin() + size_t(keep_from - base));
+			base = keep_from;
 		}
-
-		// транспонируем выходную матрицу
-		// из K x rOs в rOs x K
-		transpose(out_mtx1, out_mtx2);
-
-		// выводим матрицу out_mtx2
-		written += spectrum.write(out_mtx2, out_mtx2.size());
-
 	}
 
-end:
-	// закрываем поток
 	spectrum.close();
-	// удаляем выделенные буферы
-	conv_free(conv_in_buf);
-	spl_free(out_buf);
-
 	return written;
 }
 
-
 NAMESPACE_SPL_END;
@@ -8,7 +8,9 @@
 
 #include "common.h"
 #include "spl_types.h"
+#include "conv.h"
 #include "../io/io.h"
+#include <memory>
 
 NAMESPACE_SPL_BEGIN;
 
@@ -16,13 +18,25 @@ NAMESPACE_SPL_BEGIN;
 /// Вычисление спектрограммы.
 /// Использует оптимизацию вычисления свертки через FFT.
 ///
+/// Шаг \a hop > 1 - прореженный выход: вычисляются только кадры 0, hop, 2*hop, ... 
+///  (кадр i соответствует отсчету сигнала i * hop). При небольшом шаге используется
+///  та же свертка через FFT, но модуль вычисляется и выводится только для нужных кадров;
+///  при большом шаге (когда это дешевле по оценке стоимости) кадры считаются прямо
+///  по окну фильтров, без FFT.
+///
+/// Рабочая память свертки создается в конструкторе, поэтому execute() не выделяет память,
+///  но один вычислитель нельзя одновременно исполнять из нескольких потоков.
+///
 
 class spectrum_calculator :
     public io::filter<signal_t, spectrum_t>
 {
 public:
 
-    spectrum_calculator(const freq_scale_t& s, freq_t F, double ksi);
+    /// \a N - размер окна циклической свертки (CONV_SIZ_AUTO - выбирается автоматически 
+    ///  по размеру окна фильтров и ожидаемой длине сигнала \a length, см. cconv_choose_size).
+    spectrum_calculator(const freq_scale_t& s, freq_t F, double ksi, 
+        int N = CONV_SIZ_AUTO, size_t length = 0, int hop = 1);
     ~spectrum_calculator();
 
     size_t execute(io::istream<signal_t>& signal, io::ostream<spectrum_t>& spectrum) const override;
@@ -30,14 +44,35 @@ public:
     /// Сохранить параметры в файл.
     bool save(const char *filepath);
 
+    /// Размер окна циклической свертки.
+    int block_size() const { return N; }
+
+    /// Шаг между кадрами выхода (в отсчетах сигнала).
+    int hop_size() const { return hop; }
+
+    /// Кадры вычисляются прямой сверткой (без FFT).
+    bool direct() const { return Hd != nullptr; }
+
     // TODO: загрузка из файла, параметр Ws вычислять с помощью обратного Фурье.
     spectrum_calculator(const char *filepath);
 
 private:
-    int K, Ws;
-    double *H;
+    int K, Ws, N, hop;
+    std::unique_ptr<real_t[], conv_deleter> H;
+    /// Коэффициенты фильтров для прямой свертки: 2 x Ws x K (cos/sin, отсчет окна, канал).
+    std::unique_ptr<real_t[], spl_deleter> Hd;
+
+    //@{
+    /// Рабочая память свертки через FFT (не создается для прямой свертки):
+    ///  пакетная свертка по каналам, входной буфер и A = FFT(a) (3N + 2 чисел),
+    ///  выходная матрица Os x K, если поток не дает писать в свою память.
+    std::unique_ptr<cconv_batch> conv;
+    std::unique_ptr<real_t[], conv_deleter> conv_in;
+    std::unique_ptr<spectrum_t[], spl_deleter> out_buf;
+    //@}
 
-    bool init(const freq_scale_t& scale, freq_t F, double ksi);
+    bool init(const freq_scale_t& scale, freq_t F, double ksi, size_t length);
+    size_t execute_direct(io::istream<signal_t>& signal, io::ostream<spectrum_t>& spectrum) const;
 };
 
 NAMESPACE_SPL_END;
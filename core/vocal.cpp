@@ -8,22 +8,21 @@
 #include "model.h"
 #include "mask.h"
 #include "matrix.h"
+#include "bits.h"
+#include "simd.h"
 #include "../io/iomem.h"
 #include "../io/iofile.h"
-#include "../io/iobit.h"
 
-#include "mpir.h"
 #include <algorithm>
-#include <queue>
+#include <vector>
 using std::fill_n;
 
 #define CEIL_MODULUS(x,y) ( ( (x) + (y) - 1 ) / (y) )
 
 NAMESPACE_SPL_BEGIN;
 
-#define vec_add_limb mpn_add_n
-#define vec_sub_limb mpn_sub_n
-#define popcount_limb mpn_hamdist
+#define vec_add_limb bytes_add_n
+#define vec_sub_limb bytes_sub_n
 
 const int num_part_bits = 8;
 const int num_part_variants = 1 << num_part_bits;
@@ -127,10 +126,9 @@ bool pitch_calculator::init(const mask_params_t& pm, const pitch_params_t& p)
 
         // одновременная маскировка
         io::imstream<spectrum_t> input(&I(kt, 0), K);
-        io::omstream<limb_t> output_u(tpl, num_sample_limbs);
-        io::obitwrap<limb_t> output_b(output_u);
+        io::omstream<mask_word_t> output(tpl, num_sample_limbs);
 
-        if (mask_calc.execute(input, output_b) != K) {
+        if (mask_calc.execute(input, output) != num_sample_limbs) {
             // обработка ошибки  
             spl_free(memory);
             r = false;
@@ -185,7 +183,10 @@ out:
 }
 
 pitch_calculator::pitch_calculator(const freq_scale_t& sc, const mask_params_t& pm, const pitch_params_t& pp) :
-    scale(freq_scale_t::copy(sc)), max_diff(DEFAULT_PITCH_MAX_DIFF)
+    scale(freq_scale_t::copy(sc)), max_diff(DEFAULT_PITCH_MAX_DIFF),
+    matcher(simd_level() >= simd_avx2 ? pitch_matcher_t::popcount : pitch_matcher_t::table),
+    num_candidates(DEFAULT_PITCH_CANDIDATES),
+    hop(1)
 {
     if (!init(pm, pp)) {
         throw "Failed to create pitch_calculator";
@@ -222,6 +223,20 @@ inline limb_t get_part<4>(limb_t *s1p, int num_part) {
 
 
 size_t pitch_calculator::execute(io::istream<mask_t>& in_str, io::ostream<short>& out_str) const
+{
+    mask_pack_istream packed(in_str, K);
+    return execute(packed, out_str);
+}
+
+size_t pitch_calculator::execute(io::istream<mask_word_t>& in_str, io::ostream<short>& out_str) const
+{
+    io::iwrapdecimate<mask_word_t> decimated(in_str, mask_frame_words(K), hop);
+    io::istream<mask_word_t>& mask = hop > 1 ? decimated : in_str;
+    return matcher == pitch_matcher_t::table ? 
+        execute_table(mask, out_str) : execute_popcount(mask, out_str);
+}
+
+size_t pitch_calculator::execute_table(io::istream<mask_word_t>& in_str, io::ostream<short>& out_str) const
 {
 	// тип для хранения количества отличий (diff count) между сэмплом и маской
 	// для этого достаточно одного байта
@@ -254,7 +269,7 @@ size_t pitch_calculator::execute(io::istream<mask_t>& in_str, io::ostream<short>
 	// инициализация таблиц поиска
 	// выделяем место под таблицы
 	limb_t *mem_tables = spl_alloc<limb_t>(num_sample_parts * num_part_variants * num_diff_limbs
-        + num_sample_parts * 2 + num_diff_limbs + num_sample_limbs * 2 + sizeof(mask_t) * K);
+        + num_sample_parts * 2 + num_diff_limbs + num_sample_limbs * 2);
     limb_t *buffer = mem_tables;
 
 	// ссылка для быстрого сложения
@@ -285,7 +300,7 @@ size_t pitch_calculator::execute(io::istream<mask_t>& in_str, io::ostream<short>
 			for(limb_t j = 0; j < num_part_variants; j++) {
 				// нам нужно расстояние хэмминга между i-той частью k-того шаблона и j-тым вариантом i-той части
                 limb_t z = j & y;
-                diff_tables(i, j, k) = (diff_t)popcount_limb(&x, &z, 1);
+                diff_tables(i, j, k) = (diff_t)popcount_word(x ^ z);
             }
 
 			// индексы суммирования
@@ -308,22 +323,12 @@ size_t pitch_calculator::execute(io::istream<mask_t>& in_str, io::ostream<short>
 	limb_t *diff_limbs = buffer; buffer += num_diff_limbs;
 	limb_t *input_limbs = buffer; buffer += num_sample_limbs;
 	limb_t *input2_limbs = buffer; buffer += num_sample_limbs;
-	mask_t *input = (mask_t *) buffer;
 	diff_t *diffs = (diff_t *) diff_limbs;
 	
-	const int limb_bits = sizeof(limb_t) * 8;
 	bool first = true;
-	while(in_str.read(input, K) == K) {
-
-		// конвертируем в биты
-		fill_n(input_limbs, num_sample_limbs, 0);
-		for(size_t i = 0; i < K; i++) {
-			size_t n_byte = i / limb_bits;
-			size_t n_bit  = i % limb_bits;
-			if(input[i]) {
-				input_limbs[n_byte] |= limb_t(1) << n_bit;
-			}
-		}
+	size_t frames = 0;
+	// кадр читается сразу в виде чисел (упакован маскировкой)
+	while(in_str.read(input_limbs, num_sample_limbs) == size_t(num_sample_limbs)) {
 
         // считаем разницы для всех шаблонов
 		if(first) {
@@ -383,6 +388,7 @@ size_t pitch_calculator::execute(io::istream<mask_t>& in_str, io::ostream<short>
 		} else {
 			out_str.put(-1);
 		}
+		frames++;
 
 		// save old input
 		limb_t *tmp = input_limbs;
@@ -393,130 +399,450 @@ size_t pitch_calculator::execute(io::istream<mask_t>& in_str, io::ostream<short>
 	out_str.close(); // закрыть поток (с) Осипов
 	spl_free(mem_tables);
 
-	return 0;
+	return frames;
 }
 
-
-inline void keep(std::queue<short>& q, io::ostream<short>& o, short c) { q.push(c); }
-inline void reset(std::queue<short>& q, io::ostream<short>& o, short c) {
-	while(!q.empty()) q.pop(); 
+/// Шаблоны по словам (V[w * T + t], M[w * T + t]) для сравнения подсчетом бит.
+void pitch_calculator::popcount_templates(int T, mask_word_t *V, mask_word_t *M) const
+{
+	const int num_templates = k2 - k1 + 1;
+	const int W = int(mask_frame_words(K));
+
+	// количество кусков по 8 бит в сэмпле и шаблонов в одном числе счетчиков (см. execute_table)
+	const int num_sample_parts = CEIL_MODULUS(K, 8);
+	const int num_limb_diffs = sizeof(limb_t);
+
+	const mask_word_t *tpl_values = (const mask_word_t *)memory;
+	const mask_word_t *tpl_masks = tpl_values + W * num_templates;
+	fill_n(V, W * T, 0);
+	fill_n(M, W * T, 0);
+
+	// часть i учитывается для тех же шаблонов, что и в табличном варианте:
+	//  от числа счетчиков первого до числа счетчиков последнего шаблона с ненулевой маской части
+	for (int i = 0; i < num_sample_parts; i++) {
+		const int w = i / 8, shift = i % 8 * 8;
+		int kf = -1, kl = -1;
+		for (int k = 0; k < num_templates; k++) {
+			if ((tpl_masks[k * W + w] >> shift) & 0xFF) {
+				if (kf < 0) kf = k;
+				kl = k;
+			}
+		}
+		if (kf < 0) continue;
+		const int t1 = kf / num_limb_diffs * num_limb_diffs;
+		const int t2 = std::min((kl / num_limb_diffs + 1) * num_limb_diffs, num_templates);
+		const mask_word_t part = mask_word_t(0xFF) << shift;
+		for (int k = t1; k < t2; k++) {
+			V[w * T + k] |= tpl_values[k * W + w] & part;
+			M[w * T + k] |= tpl_masks[k * W + w] & part;
+		}
+	}
 }
-inline void flush(std::queue<short>& q, io::ostream<short>& o, short c) {
-	while(!q.empty()) {
-		o.put(q.front());
-		q.pop();
+
+size_t pitch_calculator::execute_popcount(io::istream<mask_word_t>& in_str, io::ostream<short>& out_str) const
+{
+	const int num_templates = k2 - k1 + 1;
+	const int W = int(mask_frame_words(K));
+	const int T = CEIL_MODULUS(num_templates, PITCH_TEMPLATE_BLOCK) * PITCH_TEMPLATE_BLOCK;
+
+	// шаблоны, расстояния, входные кадры
+	mask_word_t *mem = spl_alloc<mask_word_t>(2 * W * T + T / 2 + PITCH_READ_FRAMES * W);
+	mask_word_t *V = mem, *M = mem + W * T;
+	uint32_t *dist = (uint32_t *)(M + W * T);
+	mask_word_t *input = M + W * T + T / 2;
+	popcount_templates(T, V, M);
+
+	// кадры читаются пачками - по возможности прямо из памяти входного потока (без копирования)
+	size_t count = 0;
+	for (;;) {
+		size_t n = PITCH_READ_FRAMES * W;
+		const mask_word_t *frames = in_str.acquire_read(input, n, W);
+		const size_t F = n / W;
+		for (size_t f = 0; f < F; f++) {
+			pitch_distances(T, W, V, M, frames + f * W, dist);
+			const size_t k = pitch_argmin(num_templates, dist);
+
+			// если нас устраивает это отличие, мы выводим номер канала, иначе - -1
+			out_str.put(dist[k] < uint32_t(max_diff) ? short(k1 + k) : short(-1));
+		}
+		in_str.commit_read(n);
+		count += F;
+		if (F == 0) break;
 	}
-	o.put(c);
+
+	out_str.close();
+	spl_free(mem);
+
+	return count;
 }
 
-// функция сегментации сигнала по признаку вокализованности
-size_t vocal_segment(
-	io::istream<short>& in_str,
-	io::ostream<short>& out_str,
-	const freq_t F,
-	const vocal_params_t& p
-) {
-	// минимальная длительность вокализованного участка в отсчетах:
-	int minV = int(p.minV * F);
-	// минимальная длительность невокализованного участка в отсчетах:
-	int minNV = int(p.minNV * F);
-
-	bool VocP = false, Voc;
-	short kffp = 0, kff;
-	int Tnv = 0, Tkv = 0, T = 0;
-
-	size_t written = 0;
-
-	std::queue<short> q;
-
-	enum { out_v, out_nv, keep } action = keep;
-
-	while(in_str.get(kff)) {
-		kff = kff + 1; // приводим к шкале 1:K
-		Voc = kff != 0;
-
-		// посреди вокализованного сегмента
-		if(VocP && Voc) { 
-			// должен быть плавный переход между каналами
-			if( kff - kffp < 2 && kffp - kff < 2 ) {
-				// достигли минимальной длительности вокализованного
-				if(T - Tnv == minV 
-				// и невокализованный сегмент достаточно большой длительности
-				&& Tnv - Tkv > minNV
-				){
-					// фиксируем границу Tnv
-
-					// нужно сбросить все, что запомнили
-					action = out_v;
-				}
-			// если переход неплавный
-			} else {
-				// то звук невокализованный
-				Voc = false;
-			}
+size_t pitch_calculator::execute(io::istream<mask_word_t>& mask_str, io::ostream<pitch_candidate_t>& out_str) const
+{
+	io::iwrapdecimate<mask_word_t> decimated(mask_str, mask_frame_words(K), hop);
+	io::istream<mask_word_t>& in_str = hop > 1 ? decimated : mask_str;
+	const int num_templates = k2 - k1 + 1;
+	const int W = int(mask_frame_words(K));
+	const int T = CEIL_MODULUS(num_templates, PITCH_TEMPLATE_BLOCK) * PITCH_TEMPLATE_BLOCK;
+	const int N = num_candidates;
+	const int Nv = std::min(N, num_templates);
+
+	mask_word_t *mem = spl_alloc<mask_word_t>(2 * W * T + T / 2 + W);
+	mask_word_t *V = mem, *M = mem + W * T;
+	uint32_t *dist = (uint32_t *)(M + W * T);
+	mask_word_t *input = M + W * T + T / 2;
+	popcount_templates(T, V, M);
+
+	// размер области сравнения каждого шаблона - для нормировки
+	std::vector<unsigned> region(num_templates, 0);
+	for (int k = 0; k < num_templates; k++) {
+		for (int w = 0; w < W; w++) {
+			region[k] += popcount_word(M[w * T + k]);
 		}
+	}
 
-		// был невокализованный, стал вокализованный
-		if(!VocP && Voc) {
-			Tnv = T;
-			action = keep;
+	std::vector<int> order(num_templates);
+	std::vector<pitch_candidate_t> frame(N);
+	for (int n = Nv; n < N; n++) {
+		frame[n].channel = -1;
+		frame[n].distance = 0;
+		frame[n].confidence = 0;
+	}
+
+	size_t frames = 0;
+	while (in_str.read(input, W) == size_t(W)) {
+		pitch_distances(T, W, V, M, input, dist);
+
+		// N лучших шаблонов; при равных отличиях - меньший номер канала
+		for (int k = 0; k < num_templates; k++) order[k] = k;
+		std::partial_sort(order.begin(), order.begin() + Nv, order.end(), 
+			[dist](int a, int b) { return dist[a] < dist[b] || (dist[a] == dist[b] && a < b); });
+
+		for (int n = 0; n < Nv; n++) {
+			const int k = order[n];
+			frame[n].channel = short(k1 + k);
+			frame[n].distance = short(dist[k]);
+			frame[n].confidence = region[k] > dist[k] ? 1.0f - float(dist[k]) / region[k] : 0.0f;
 		}
+		if (out_str.write(frame.data(), N) != size_t(N)) break;
+		frames++;
+	}
 
-		// был вокализованный, стал невокализованный
-		if(VocP && !Voc) {
-			// вокализованный сегмент достаточной длительности
-			if(T - Tnv > minV) {
-				Tkv = T;
-				action = keep;
-			// невокализованный сегмент достаточной длительности
-			} else if(T - Tkv > minNV) {
-				// невокализованный сегмент недостаточной длительности
-				if(Tnv - Tkv <= minNV) {
-					// фиксируем границу - Tkv
-					action = out_nv;
-				}
-			}
+	out_str.close();
+	spl_free(mem);
+
+	return frames;
+}
+
+
+const pitch_track_params_t pitch_track_params_t::DEFAULT = { 64, 1, 8, 4 };
+
+pitch_tracker::pitch_tracker(const pitch_calculator& calc, const pitch_track_params_t& pp) :
+    k1(calc.first_channel()), T(calc.templates()), C(calc.candidates()),
+    unvoiced_cost(calc.max_distance() - 1), p(pp)
+{
+}
+
+size_t pitch_tracker::execute(io::istream<pitch_candidate_t>& in_str, io::ostream<short>& out_str) const
+{
+	// состояния 0..T-1 - шаблоны, T - невокализованное
+	// ключ состояния: стоимость в старших 16 битах, номер предыдущего состояния - в младших
+	typedef uint32_t key_t;
+	const int U = T, S = T + 1, L = p.lag;
+	const key_t step = key_t(p.step_cost) << 16;
+	const key_t jump = key_t(p.jump_cost) << 16;
+	const key_t voicing = key_t(p.voicing_cost) << 16;
+
+	std::vector<pitch_candidate_t> frame(C);
+	std::vector<key_t> cost(S), e(S), fwd(S), bwd(S);
+	// номера предыдущих состояний за последние L + 1 кадров (кольцевой буфер)
+	std::vector<short> back((L + 1) * S);
+
+	// решение по кадру t - L: обратный проход от лучшего состояния кадра t
+	auto trace = [&](size_t t, int s, int steps) {
+		for (int j = 0; j < steps; j++, t--) {
+			s = back[t % (L + 1) * S + s];
+		}
+		return s;
+	};
+	auto best_state = [&]() {
+		return int(std::min_element(cost.begin(), cost.end()) - cost.begin());
+	};
+	auto channel = [&](int s) { return short(s < U ? k1 + s : -1); };
+
+	size_t t = 0;
+	for (; in_str.read(frame.data(), C) == size_t(C); t++) {
+
+		// стоимость кадра: отличие от шаблона; для шаблонов не из списка - наибольшее в списке
+		key_t miss = 0;
+		for (int n = 0; n < C; n++) {
+			if (frame[n].channel >= 0) miss = std::max(miss, key_t(frame[n].distance));
 		}
+		std::fill(e.begin(), e.begin() + T, miss);
+		for (int n = 0; n < C; n++) {
+			// пустые кандидаты (-1) и каналы вне шаблонов этого вычислителя пропускаются
+			const int s = frame[n].channel - k1;
+			if (frame[n].channel >= 0 && s >= 0 && s < T) e[s] = key_t(frame[n].distance);
+		}
+		e[U] = key_t(std::max(unvoiced_cost, 0));
 
-		// посреди невокализованного участка
-		if(!VocP && !Voc) {
-			// достигли минимальной длительности невокализованного участка
-			if(T - Tkv == minNV) {
-				// фиксируем границу - Tkv
-				action = out_nv;
+		short *bp = &back[t % (L + 1) * S];
+		if (t == 0) {
+			cost = e;
+		} else {
+			// переходы между шаблонами: min(стоимость + step * |dk|) - проходы в обе стороны
+			for (int s = 0; s < T; s++) fwd[s] = bwd[s] = cost[s] << 16 | key_t(s);
+			for (int s = 1; s < T; s++) fwd[s] = std::min(fwd[s], fwd[s-1] + step);
+			for (int s = T - 2; s >= 0; s--) bwd[s] = std::min(bwd[s], bwd[s+1] + step);
+
+			// скачок с наибольшей стоимостью и начало вокализованного участка
+			const key_t best_voiced = *std::min_element(fwd.begin(), fwd.begin() + T);
+			const key_t from_jump = best_voiced + jump;
+			const key_t from_unvoiced = (cost[U] << 16 | key_t(U)) + voicing;
+
+			for (int s = 0; s < T; s++) {
+				const key_t k = std::min(std::min(fwd[s], bwd[s]), std::min(from_jump, from_unvoiced));
+				cost[s] = (k >> 16) + e[s];
+				bp[s] = short(k & 0xFFFF);
 			}
+			const key_t k = std::min(cost[U] << 16 | key_t(U), best_voiced + voicing);
+			cost[U] = (k >> 16) + e[U];
+			bp[U] = short(k & 0xFFFF);
+
+			// нормировка: стоимости остаются малыми
+			const key_t m = *std::min_element(cost.begin(), cost.end());
+			for (int s = 0; s < S; s++) cost[s] -= m;
 		}
 
-		switch(action) {
-		case out_v: 
-			while(!q.empty()) {
-				if(out_str.put(q.front() - 1))
-					written++;
-				q.pop();
-			}
-			if(out_str.put(kff - 1)) 
-				written++;
-			break;
-		case out_nv:
-			while(!q.empty()) {
-				if(out_str.put(-1))
-					written++;
-				q.pop();
-			}
-			if(out_str.put(-1)) 
-				written++;
-			break;
-		case keep:
-			q.push(kff);
-			break;
+		if (t >= size_t(L)) {
+			out_str.put(channel(trace(t, best_state(), L)));
 		}
+	}
 
-		VocP = Voc;
-		kffp = kff;
-		T++;
+	// окончание потока: решения по последним кадрам от лучшего конечного состояния
+	if (t > 0) {
+		const int n = int(std::min(t, size_t(L)));
+		std::vector<short> tail(n);
+		int s = best_state();
+		for (int j = n - 1; j >= 0; j--) {
+			tail[j] = channel(s);
+			if (j > 0) s = back[(t - n + j) % (L + 1) * S + s];
+		}
+		out_str.write(tail.data(), n);
 	}
 
-	return written;
+	out_str.close();
+	return t;
+}
+
+
+namespace {
+
+/// Размер блока вывода сегментации.
+const size_t VOCAL_BLOCK = 4096;
+
+///
+/// Сегментация как выходной поток: записанные номера каналов ЧОТ проходят сегментацию,
+///  результат выводится в оборачиваемый поток блоками по VOCAL_BLOCK.
+///
+class vocal_ostream : public io::owrap<short>
+{
+public:
+    vocal_ostream(io::ostream<short>& str, int minV_, int minNV_) :
+        io::owrap<short>(str), minV(minV_), minNV(minNV_),
+        VocP(false), kffp(0), Tnv(0), Tkv(0), T(0), action(keep),
+        _head(0), _size(0), _count(0), _written(0)
+    {
+        // обычно решение откладывается не дольше, чем на minV + minNV кадров
+        _cap = 64;
+        while (_cap < size_t(minV) + size_t(minNV) + 2) _cap *= 2;
+        _ring = spl_alloc<short>(_cap);
+        _out = spl_alloc<short>(VOCAL_BLOCK);
+    }
+
+    ~vocal_ostream() {
+        spl_free(_ring);
+        spl_free(_out);
+    }
+
+    size_t write(const short *buf, size_t count) override {
+        for (size_t i = 0; i < count; i++) push(buf[i]);
+        return count;
+    }
+
+    /// Перед закрытием выводится накопленный блок.
+    void close() override {
+        flush();
+        _understream->close();
+    }
+
+    /// Вывод накопленного блока.
+    void flush() {
+        if (_count) _written += _understream->write(_out, _count);
+        _count = 0;
+    }
+
+    /// Количество значений, записанных в оборачиваемый поток.
+    size_t written() const { return _written; }
+
+private:
+
+    /// Один кадр сегментации.
+    void push(short kff) {
+        kff = kff + 1; // приводим к шкале 1:K
+        bool Voc = kff != 0;
+
+        // посреди вокализованного сегмента
+        if (VocP && Voc) {
+            // должен быть плавный переход между каналами
+            if (kff - kffp < 2 && kffp - kff < 2) {
+                // достигли минимальной длительности вокализованного
+                // и невокализованный сегмент достаточно большой длительности
+                if (T - Tnv == minV && Tnv - Tkv > minNV) {
+                    // фиксируем границу Tnv - нужно сбросить все, что запомнили
+                    action = out_v;
+                }
+            // если переход неплавный, то звук невокализованный
+            } else {
+                Voc = false;
+            }
+        }
+
+        // был невокализованный, стал вокализованный
+        if (!VocP && Voc) {
+            Tnv = T;
+            action = keep;
+        }
+
+        // был вокализованный, стал невокализованный
+        if (VocP && !Voc) {
+            // вокализованный сегмент достаточной длительности
+            if (T - Tnv > minV) {
+                Tkv = T;
+                action = keep;
+            // невокализованный сегмент достаточной длительности,
+            //  предыдущий невокализованный - недостаточной: фиксируем границу Tkv
+            } else if (T - Tkv > minNV && Tnv - Tkv <= minNV) {
+                action = out_nv;
+            }
+        }
+
+        // посреди невокализованного участка достигли его минимальной длительности
+        if (!VocP && !Voc && T - Tkv == minNV) {
+            // фиксируем границу - Tkv
+            action = out_nv;
+        }
+
+        // в буфере хранятся исходные номера каналов (kff - 1)
+        switch (action) {
+        case out_v:
+            release(false);
+            emit(kff - 1);
+            break;
+        case out_nv:
+            release(true);
+            emit(-1);
+            break;
+        case keep:
+            if (_size == _cap) grow();
+            _ring[(_head + _size) & (_cap - 1)] = short(kff - 1);
+            _size++;
+            break;
+        }
+
+        VocP = Voc;
+        kffp = kff;
+        T++;
+    }
+
+    void emit(int x) {
+        _out[_count++] = short(x);
+        if (_count == VOCAL_BLOCK) flush();
+    }
+
+    /// Вывод отложенных кадров: как есть или как невокализованные.
+    void release(bool unvoiced) {
+        while (_size > 0) {
+            // непрерывный участок кольцевого буфера, помещающийся в блок вывода
+            const size_t n = std::min(std::min(_size, _cap - _head), VOCAL_BLOCK - _count);
+            if (unvoiced)
+                std::fill_n(_out + _count, n, short(-1));
+            else
+                std::copy(_ring + _head, _ring + _head + n, _out + _count);
+            _count += n;
+            _size -= n;
+            _head = (_head + n) & (_cap - 1);
+            if (_count == VOCAL_BLOCK) flush();
+        }
+        _head = 0;
+    }
+
+    /// Решение откладывается дольше обычного - буфер удваивается.
+    void grow() {
+        short *ring = spl_alloc<short>(2 * _cap);
+        for (size_t i = 0; i < _size; i++) ring[i] = _ring[(_head + i) & (_cap - 1)];
+        spl_free(_ring);
+        _ring = ring;
+        _cap *= 2;
+        _head = 0;
+    }
+
+    const int minV, minNV;
+
+    // состояние сегментации
+    bool VocP;
+    short kffp;
+    int Tnv, Tkv, T;
+    enum { out_v, out_nv, keep } action;
+
+    /// Отложенные кадры: кольцевой буфер размера _cap (степень 2).
+    short *_ring;
+    size_t _cap, _head, _size;
+
+    /// Блок вывода.
+    short *_out;
+    size_t _count;
+    size_t _written;
+};
+
+}
+
+vocal_calculator::vocal_calculator(freq_t F, const vocal_params_t& p, const pitch_calculator *pitch) :
+    minV(int(p.minV * F)), minNV(int(p.minNV * F)), pitch(pitch)
+{
+}
+
+size_t vocal_calculator::execute(io::istream<short>& in_str, io::ostream<short>& out_str) const
+{
+    vocal_ostream vocal(out_str, minV, minNV);
+    short buf[VOCAL_BLOCK];
+    size_t n;
+    while ((n = in_str.read(buf, VOCAL_BLOCK)) > 0)
+        vocal.write(buf, n);
+    vocal.flush();
+    return vocal.written();
+}
+
+size_t vocal_calculator::execute(io::istream<mask_word_t>& in_str, io::ostream<short>& out_str) const
+{
+    if (!pitch)
+        throw "vocal_calculator: pitch calculator is required for mask input";
+
+    // выход ЧОТ сразу проходит сегментацию; pitch_calculator закрывает поток в конце
+    vocal_ostream vocal(out_str, minV, minNV);
+    pitch->execute(in_str, static_cast<io::ostream<short>&>(vocal));
+    vocal.flush();
+    return vocal.written();
+}
+
+// функция сегментации сигнала по признаку вокализованности
+size_t vocal_segment(
+	io::istream<short>& in_str,
+	io::ostream<short>& out_str,
+	const freq_t F,
+	const vocal_params_t& p
+) {
+	vocal_calculator calc(F, p);
+	return calc.execute(in_str, out_str);
 }
 
 NAMESPACE_SPL_END;
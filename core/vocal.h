@@ -15,21 +15,93 @@
 #include "scale.h"
 #include "../io/io.h"
 #include "../io/iowrap.h"
-#include "mpir.h"
 
 
 NAMESPACE_SPL_BEGIN;
 
-typedef mp_limb_t limb_t;
+/// Число упакованного сэмпла маски и счетчиков отличий (см. bits.h).
+typedef mask_word_t limb_t;
 
+/// Способ сравнения кадров маски с шаблонами ЧОТ.
+enum class pitch_matcher_t {
+    /// Таблицы отличий по 8 бит кадра и побайтовые счетчики,
+    ///  обновляемые только для изменившихся частей кадра.
+    table,
+    /// Подсчет бит (XOR/AND) кадра сразу со всеми шаблонами и векторный поиск минимума.
+    popcount,
+};
+
+/// Количество шаблонов, обрабатываемых за одну векторную операцию (с запасом для AVX-512).
+const int PITCH_TEMPLATE_BLOCK = 8;
+
+/// Наибольшее количество кадров маски, читаемых pitch_calculator за один раз.
+const int PITCH_READ_FRAMES = 256;
+
+/// Расстояния Хэмминга кадра \a x (\a W слов) до \a T шаблонов:
+///  dist[t] = popcount(V_t ^ (x & M_t)) - отличие от значения шаблона V_t в области M_t.
+/// Шаблоны хранятся по словам: V[w * T + t], M[w * T + t]; \a T кратно PITCH_TEMPLATE_BLOCK.
+/// Векторизовано (см. simd.h).
+void pitch_distances(
+    size_t T, size_t W, const mask_word_t *V, const mask_word_t *M, 
+    const mask_word_t *x, uint32_t *dist);
+
+/// Индекс первого наименьшего из \a N (> 0) расстояний.
+/// Векторизовано (см. simd.h).
+size_t pitch_argmin(size_t N, const uint32_t *dist);
+
+/// Кандидат ЧОТ в кадре.
+struct pitch_candidate_t {
+    short channel;    ///< номер канала ЧОТ, -1 - кандидата нет
+    short distance;   ///< количество отличий маски кадра от шаблона (бит)
+    float confidence; ///< доля совпавших бит в области сравнения шаблона, от 0 до 1
+};
+
+/// Стандартное количество кандидатов ЧОТ в кадре.
+const int DEFAULT_PITCH_CANDIDATES = 3;
+
+/// Выделение ЧОТ сравнением кадров маски с шаблонами.
+/// Основной вход - упакованные кадры маски (mask_frame_words(K) слов на кадр),
+///  слова кадра используются без преобразования; вход mask_t на канал сохранен для совместимости.
+///
+/// Кроме основного выхода (номер канала или -1) есть выход кандидатов: для каждого кадра
+///  candidates() лучших шаблонов по возрастанию отличий (при равенстве - по номеру канала).
+/// Первый кандидат совпадает с основным выходом, если его отличие меньше допустимого.
+/// Все варианты execute() возвращают количество обработанных кадров (как pitch_tracker).
 class pitch_calculator :
-    public io::filter<mask_t, short>
+    public io::filter<mask_t, short>,
+    public io::filter<mask_word_t, short>,
+    public io::filter<mask_word_t, pitch_candidate_t>
 {
 public:
     pitch_calculator(const freq_scale_t& scale, const mask_params_t& pm, const pitch_params_t& pp);
     ~pitch_calculator();
 
     size_t execute(io::istream<mask_t>& mask, io::ostream<short>& pitch) const override;
+    size_t execute(io::istream<mask_word_t>& mask, io::ostream<short>& pitch) const override;
+
+    /// Кандидаты ЧОТ: candidates() значений на кадр.
+    size_t execute(io::istream<mask_word_t>& mask, io::ostream<pitch_candidate_t>& pitch) const override;
+
+    /// Количество кандидатов в кадре (по умолчанию DEFAULT_PITCH_CANDIDATES),
+    ///  ограничивается отрезком [1, templates()].
+    void set_candidates(int n) { num_candidates = n < 1 ? 1 : n > templates() ? templates() : n; }
+    int candidates() const { return num_candidates; }
+
+    /// Шаг прореживания входных кадров маски: ЧОТ определяется для кадров 0, hop, 2*hop, ...
+    void set_hop(int h) { hop = h < 1 ? 1 : h; }
+    int hop_size() const { return hop; }
+
+    /// Номер канала первого шаблона и количество шаблонов.
+    int first_channel() const { return k1; }
+    int templates() const { return k2 - k1 + 1; }
+
+    /// Максимальное отклонение маски вокализованного кадра от шаблона.
+    int max_distance() const { return max_diff; }
+
+    /// Выбор способа сравнения с шаблонами (результаты обоих способов совпадают).
+    /// По умолчанию - подсчет бит, если доступны векторные инструкции, иначе табличный.
+    void set_matcher(pitch_matcher_t m) { matcher = m; }
+    pitch_matcher_t get_matcher() const { return matcher; }
 
 private:
     freq_scale_t scale;
@@ -37,8 +109,14 @@ private:
     int k1, k2;
     const int max_diff;
     void *memory;
+    pitch_matcher_t matcher;
+    int num_candidates;
+    int hop;
 
     bool init(const mask_params_t& pm, const pitch_params_t& pp);    
+    size_t execute_table(io::istream<mask_word_t>& mask, io::ostream<short>& pitch) const;
+    size_t execute_popcount(io::istream<mask_word_t>& mask, io::ostream<short>& pitch) const;
+    void popcount_templates(int T, mask_word_t *V, mask_word_t *M) const;
 };
 
 
@@ -46,6 +124,74 @@ private:
 const int DEFAULT_PITCH_MAX_DIFF = 6;
 
 
+/// Параметры сопровождения ЧОТ (pitch_tracker). Все стоимости - в битах отличия от шаблона.
+struct pitch_track_params_t {
+    int lag;            ///< задержка решения (кадров): решение по кадру принимается через lag кадров
+    int step_cost;      ///< стоимость перехода ЧОТ на один канал между соседними кадрами
+    int jump_cost;      ///< наибольшая стоимость перехода (скачки на любое число каналов)
+    int voicing_cost;   ///< стоимость перехода вокализованный <-> невокализованный
+
+    static const pitch_track_params_t DEFAULT;
+};
+
+///
+/// Сопровождение ЧОТ: потоковый алгоритм Витерби с ограниченной задержкой.
+/// Вход - кандидаты pitch_calculator (candidates() на кадр; для полного вектора отличий 
+///  candidates() = templates()), выход - номер канала ЧОТ или -1, как у pitch_calculator.
+/// Состояния - шаблоны ЧОТ и невокализованное состояние; стоимость кадра - отличие от шаблона
+///  (для невокализованного - max_distance() - 1), стоимость перехода - min(step_cost * |dk|, jump_cost).
+/// Переход со стоимостью, линейной по числу каналов, вычисляется за O(T) двумя проходами
+///  (по возрастанию и по убыванию канала); стоимость и номер предыдущего состояния
+///  упакованы в одно целое, поэтому выбор минимума не содержит ветвлений.
+/// Решение по кадру выдается через lag кадров; память не зависит от длины сигнала.
+/// При нулевых стоимостях переходов выход совпадает с выходом pitch_calculator.
+///
+class pitch_tracker :
+    public io::filter<pitch_candidate_t, short>
+{
+public:
+    pitch_tracker(const pitch_calculator& calc, const pitch_track_params_t& p = pitch_track_params_t::DEFAULT);
+
+    size_t execute(io::istream<pitch_candidate_t>& candidates, io::ostream<short>& pitch) const override;
+
+private:
+    const int k1, T, C;
+    const int unvoiced_cost;
+    const pitch_track_params_t p;
+};
+
+
+///
+/// Сегментация по признаку вокализованности (см. vocal_segment).
+/// Вход - номера каналов ЧОТ (-1 - невокализованный кадр), выход - те же номера,
+///  где кадры сегментов недостаточной длительности заменены на -1.
+///
+/// Решение по кадру откладывается, пока не определится длительность сегмента; отложенные
+///  кадры хранятся в кольцевом буфере, начальный размер которого определяется minV и minNV
+///  (буфер растет, только если решение откладывается дольше). Выход пишется блоками.
+///
+/// Если задан вычислитель ЧОТ \a pitch, вход может быть маской (mask_word_t):
+///  ЧОТ и сегментация выполняются в одном потоке, выход pitch_calculator передается 
+///  сегментации без промежуточного потока.
+///
+class vocal_calculator :
+    public io::filter<short, short>,
+    public io::filter<mask_word_t, short>
+{
+public:
+    /// \a F - частота кадров ЧОТ.
+    vocal_calculator(freq_t F, const vocal_params_t& p, const pitch_calculator *pitch = 0);
+
+    size_t execute(io::istream<short>& pitch, io::ostream<short>& vocal) const override;
+    size_t execute(io::istream<mask_word_t>& mask, io::ostream<short>& vocal) const override;
+
+private:
+    /// Минимальные длительности вокализованного и невокализованного сегментов (в кадрах).
+    int minV, minNV;
+    const pitch_calculator *pitch;
+};
+
+
 class freq_translator : public io::owrapelem<short, freq_t>
 {
 public:
@@ -57,6 +203,11 @@ public:
         f = i < 0 ? 0.0 : freqs[i];
     }
 
+    void convert_block(const short *i, freq_t *f, size_t count) const override
+    {
+        for (size_t j = 0; j < count; j++) f[j] = i[j] < 0 ? 0.0 : freqs[i[j]];
+    }
+
     const freq_t *freqs;
 };
 
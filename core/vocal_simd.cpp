@@ -0,0 +1,150 @@
+///
+/// \file  vocal_simd.cpp
+/// \brief Векторные ядра сравнения кадров маски с шаблонами ЧОТ
+///
+/// Кадр маски сравнивается сразу со всеми шаблонами: шаблоны хранятся по словам
+///  (слово w всех шаблонов подряд), поэтому одна векторная операция обрабатывает
+///  слово кадра для нескольких шаблонов. Биты считаются в 64-битных элементах:
+///  AVX-512 VPOPCNTDQ, либо таблицей по 4 бита (vpshufb) и суммой байт (vpsadbw) для AVX2.
+///
+
+#include "vocal.h"
+#include "bits.h"
+#include "simd_ops.h"
+using spl::mask_word_t;
+using spl::popcount_word;
+
+#include <algorithm>
+
+namespace {
+
+void distances_scalar(
+ size_t T, size_t W, const mask_word_t *V, const mask_word_t *M,
+ const mask_word_t *x, uint32_t *dist)
+{
+  for(size_t t = 0; t < T; t++) {
+    unsigned d = 0;
+    for(size_t w = 0; w < W; w++)
+      d += popcount_word(V[w * T + t] ^ (x[w] & M[w * T + t]));
+    dist[t] = d;
+  }
+}
+
+size_t argmin_scalar(size_t N, const uint32_t *dist, size_t i, size_t best) {
+  for(; i < N; i++) {
+    if(dist[i] < dist[best]) best = i;
+  }
+  return best;
+}
+
+#ifdef SPL_SIMD_X86
+
+/// Подсчет бит в 64-битных элементах: таблица для полубайтов и сумма байт.
+SPL_TARGET_AVX2 inline __m256i popcount_avx2(__m256i v) {
+  const __m256i lut = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0F);
+  const __m256i lo = _mm256_and_si256(v, low);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+  const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+  return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+/// 4 шаблона на регистр; суммы из 64-битных элементов сжимаются в 32-битные.
+SPL_TARGET_AVX2 void distances_avx2(
+ size_t T, size_t W, const mask_word_t *V, const mask_word_t *M,
+ const mask_word_t *x, uint32_t *dist)
+{
+  const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  for(size_t t = 0; t < T; t += 4) {
+    __m256i acc = _mm256_setzero_si256();
+    for(size_t w = 0; w < W; w++) {
+      const __m256i xw = _mm256_set1_epi64x((long long)x[w]);
+      const __m256i v = _mm256_loadu_si256((const __m256i *)(V + w * T + t));
+      const __m256i m = _mm256_loadu_si256((const __m256i *)(M + w * T + t));
+      acc = _mm256_add_epi64(acc, popcount_avx2(_mm256_xor_si256(v, _mm256_and_si256(xw, m))));
+    }
+    _mm_storeu_si128((__m128i *)(dist + t),
+      _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(acc, pack)));
+  }
+}
+
+/// 8 шаблонов на регистр, VPOPCNTQ.
+SPL_TARGET_AVX512_VPOPCNT void distances_avx512(
+ size_t T, size_t W, const mask_word_t *V, const mask_word_t *M,
+ const mask_word_t *x, uint32_t *dist)
+{
+  for(size_t t = 0; t < T; t += 8) {
+    __m512i acc = _mm512_setzero_si512();
+    for(size_t w = 0; w < W; w++) {
+      const __m512i xw = _mm512_set1_epi64((long long)x[w]);
+      const __m512i v = _mm512_loadu_si512(V + w * T + t);
+      const __m512i m = _mm512_loadu_si512(M + w * T + t);
+      acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_xor_si512(v, _mm512_and_si512(xw, m))));
+    }
+    _mm256_storeu_si256((__m256i *)(dist + t), _mm512_cvtepi64_epi32(acc));
+  }
+}
+
+/// Поиск минимума: векторный минимум по блокам, затем первый блок, где он достигается.
+SPL_TARGET_AVX2 size_t argmin_avx2(size_t N, const uint32_t *dist) {
+  const size_t N8 = N & ~size_t(7);
+  if(N8 == 0) return argmin_scalar(N, dist, 1, 0);
+
+  __m256i mn = _mm256_loadu_si256((const __m256i *)dist);
+  for(size_t i = 8; i < N8; i += 8)
+    mn = _mm256_min_epu32(mn, _mm256_loadu_si256((const __m256i *)(dist + i)));
+  // минимум по элементам регистра
+  mn = _mm256_min_epu32(mn, _mm256_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+  mn = _mm256_min_epu32(mn, _mm256_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+  mn = _mm256_min_epu32(mn, _mm256_permute2x128_si256(mn, mn, 0x01));
+
+  size_t best = 0;
+  for(size_t i = 0; i < N8; i += 8) {
+    const __m256i eq = _mm256_cmpeq_epi32(mn, _mm256_loadu_si256((const __m256i *)(dist + i)));
+    const unsigned bits = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+    if(bits) {
+      best = i;
+      while(!((bits >> (best - i)) & 1)) best++;
+      break;
+    }
+  }
+  return argmin_scalar(N, dist, N8, best);
+}
+
+#endif
+
+}
+
+NAMESPACE_SPL_BEGIN;
+
+void pitch_distances(
+ size_t T, size_t W, const mask_word_t *V, const mask_word_t *M,
+ const mask_word_t *x, uint32_t *dist)
+{
+#ifdef SPL_SIMD_X86
+  switch(simd_level()) {
+  case simd_avx512:
+    // без VPOPCNTDQ - вариант AVX2
+    if(simd_avx512_vpopcnt()) distances_avx512(T, W, V, M, x, dist);
+    else                       distances_avx2(T, W, V, M, x, dist);
+    return;
+  case simd_avx2: distances_avx2(T, W, V, M, x, dist); return;
+  default: break;
+  }
+#endif
+  distances_scalar(T, W, V, M, x, dist);
+}
+
+size_t pitch_argmin(size_t N, const uint32_t *dist)
+{
+#ifdef SPL_SIMD_X86
+  // AVX-512 для десятков-сотен шаблонов выигрыша не дает
+  if(simd_level() >= simd_avx2)
+    return argmin_avx2(N, dist);
+#endif
+  return argmin_scalar(N, dist, 1, 0);
+}
+
+NAMESPACE_SPL_END;
@@ -123,6 +123,23 @@ public:
 	}
 	//@}
 
+	//@{
+	/// Zero-copy input.
+	/// acquire_read() returns up to \a count elements (\a count is set to their number).
+	/// If the stream keeps data in memory and has at least \a unit contiguous elements,
+	///  they are returned in place (a multiple of \a unit); otherwise data is read into \a buf.
+	/// Less than \a unit elements are returned only at the end of stream.
+	/// The elements stay valid until commit_read(), which must get the same \a count.
+	///
+	/// Default implementation reads into \a buf (\ref read).
+	virtual const T *acquire_read(T *buf, size_t& count, size_t unit = 1) {
+		count = read(buf, count);
+		return buf;
+	}
+
+	virtual void commit_read(size_t count) {}
+	//@}
+
 };
 
 
@@ -173,6 +190,25 @@ public:
 	}
 	//@}
 
+	//@{
+	/// Zero-copy output.
+	/// acquire_write() returns memory for up to \a count elements to be filled and passed to commit_write().
+	/// If the stream keeps data in memory and has room for at least \a unit contiguous elements,
+	///  its own memory is returned and \a count is reduced to that room (a multiple of \a unit);
+	///  otherwise \a buf is returned and \a count is not changed.
+	/// commit_write() outputs first \a count elements of the span and returns number of elements written.
+	/// A span may be dropped without commit.
+	///
+	/// Default implementation returns \a buf and writes it (\ref write).
+	virtual T *acquire_write(T *buf, size_t& count, size_t unit = 1) {
+		return buf;
+	}
+
+	virtual size_t commit_write(const T *span, size_t count) {
+		return write(span, count);
+	}
+	//@}
+
 };
 
 
@@ -0,0 +1,220 @@
+#include "ioasync.h"
+#include "iofile.h"
+using namespace io;
+
+#include <string.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+typedef unsigned char byte;
+
+///
+/// Output file stream of bytes with the writer thread.
+/// The producer fills the current block (submitted % size) and submits it, the writer thread
+///  writes submitted blocks in order and frees them (written counter).
+/// The producer waits only when it starts a new block and all blocks are submitted, but not written.
+///
+class aofile_out:
+	public ostream<byte>
+{
+public:
+	aofile_out(const char *filename, size_t bufsize_, size_t max_blocks):
+	  file(filename), bufsize(std::max<size_t>(bufsize_, 1)), size(std::max<size_t>(max_blocks, 1)),
+	  stride((bufsize + IOASYNC_ALIGN - 1) / IOASYNC_ALIGN * IOASYNC_ALIGN),
+	  memory(new byte[stride * size + IOASYNC_ALIGN]), fill(new size_t[size]),
+	  submitted(0), written(0), cur_fill(0), span(0), _pos(0), failed(false), closing(false), closed(false)
+	{
+		// blocks start at page boundaries in memory; the file is buffered and written by blocks of any size
+		const size_t shift = (IOASYNC_ALIGN - size_t(memory.get()) % IOASYNC_ALIGN) % IOASYNC_ALIGN;
+		blocks = memory.get() + shift;
+		writer = std::thread([this]() { run(); });
+	}
+
+	~aofile_out() {
+		close();
+	}
+
+	virtual size_t write(const byte *data, size_t count);
+
+	virtual byte *acquire_write(byte *buf, size_t& count, size_t unit);
+	virtual size_t commit_write(const byte *data, size_t count);
+
+	virtual size_t pos() const {
+		return _pos;
+	}
+
+	virtual size_t pos(size_t newpos) {
+		throw "Not implemented";
+	}
+
+	virtual size_t skip(size_t N) {
+		throw "Not implemented";
+	}
+
+	virtual bool eos() const {
+		return closed || failed.load();
+	}
+
+	virtual void close();
+
+	/// A block was not written.
+	bool error() const {
+		return failed.load();
+	}
+
+private:
+	/// Writer thread.
+	void run();
+
+	/// Current block: waits until it is written, if it is not started yet. Returns 0 after an error.
+	byte *current();
+
+	/// Pass the current block to the writer (if it is not empty).
+	void submit();
+
+	ofstream<byte> file;
+	const size_t bufsize, size, stride;
+	std::unique_ptr<byte[]> memory;
+	std::unique_ptr<size_t[]> fill;
+	byte *blocks;
+
+	/// Counters of submitted and written blocks (block index is counter % size), guarded by mutex.
+	size_t submitted, written;
+
+	/// Filled bytes of the current block and the span, given by acquire_write() (producer only).
+	size_t cur_fill;
+	byte *span;
+	size_t _pos;
+
+	std::atomic<bool> failed;
+	bool closing, closed;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::thread writer;
+};
+
+byte *aofile_out::current() {
+	if(cur_fill == 0) {
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this]() { return submitted - written < size || failed.load(); });
+	}
+	return failed.load() ? 0 : blocks + (submitted % size) * stride;
+}
+
+void aofile_out::submit() {
+	if(cur_fill == 0) return;
+	fill[submitted % size] = cur_fill;
+	cur_fill = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		submitted++;
+	}
+	cond.notify_all();
+}
+
+size_t aofile_out::write(const byte *data, size_t count) {
+	size_t done = 0;
+	while(done < count && !closed) {
+		byte *block = current();
+		if(!block) break;
+		size_t n = std::min(count - done, bufsize - cur_fill);
+		memcpy(block + cur_fill, data + done, n);
+		cur_fill += n;
+		done += n;
+		if(cur_fill == bufsize) submit();
+	}
+	_pos += done;
+	return done;
+}
+
+byte *aofile_out::acquire_write(byte *buf, size_t& count, size_t unit) {
+	span = 0;
+	if(closed || unit > bufsize) return buf;
+	// the rest of the current block is too small - pass it as is
+	if(bufsize - cur_fill < unit) submit();
+	byte *block = current();
+	if(!block) return buf;
+	count = std::min(count, (bufsize - cur_fill) / unit * unit);
+	span = block + cur_fill;
+	return span;
+}
+
+size_t aofile_out::commit_write(const byte *data, size_t count) {
+	if(!span || data != span) return write(data, count);
+	span = 0;
+	cur_fill += count;
+	_pos += count;
+	if(cur_fill == bufsize) submit();
+	return count;
+}
+
+void aofile_out::run() {
+	for(;;) {
+		size_t i;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [this]() { return written != submitted || closing; });
+			if(written == submitted) break;
+			i = written % size;
+		}
+		// after an error blocks are dropped, so the producer does not wait
+		if(!failed.load() && file.write(blocks + i * stride, fill[i]) != fill[i])
+			failed.store(true);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			written++;
+		}
+		cond.notify_all();
+	}
+	// the end of data can stay in the buffer of the file: its write error is found only by flush
+	if(!failed.load() && !file.flush())
+		failed.store(true);
+}
+
+void aofile_out::close() {
+	if(closed) return;
+	submit();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	cond.notify_all();
+	writer.join();
+	file.close();
+	closed = true;
+}
+
+class ioasync_file:
+	public ioasync_impl
+{
+public:
+	ioasync_file(const char *filename, size_t block_size, size_t blocks):
+	  _out(filename, block_size, blocks)
+	{
+	}
+
+	virtual ostream<byte>& output() {
+		return _out;
+	}
+
+	virtual bool failed() const {
+		return _out.error();
+	}
+
+private:
+	aofile_out _out;
+};
+
+ioasync_impl *ioasync_impl::create(const char *filename, size_t block_size, size_t blocks) {
+	return new ioasync_file(filename, block_size, blocks);
+}
+
+void ioasync_impl::destroy(ioasync_impl *impl) {
+	delete impl;
+}
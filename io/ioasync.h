@@ -0,0 +1,94 @@
+#ifndef _IO_ASYNC_
+#define _IO_ASYNC_
+
+///
+/// \file  ioasync.h
+/// \brief Asynchronous output file stream.
+///
+/// Data is collected in large blocks, filled blocks are written to the file
+///  by a separate thread, so the computing thread does not wait for the disk.
+///
+
+#include "io.h"
+#include "iowrap.h"
+#include <algorithm>
+
+namespace io {
+
+/// Block size (in bytes) and number of blocks of \ref aofstream by default:
+///  one block is filled, while the other is written.
+const size_t IOASYNC_BLOCK_SIZE = 1 << 22;
+const size_t IOASYNC_BLOCKS = 2;
+
+/// Alignment of blocks in memory (in bytes); file writes are not aligned.
+const size_t IOASYNC_ALIGN = 1 << 12;
+
+class ioasync_impl
+{
+public:
+	typedef unsigned char byte;
+	static ioasync_impl *create(const char *filename, size_t block_size, size_t blocks);
+	static void destroy(ioasync_impl *impl);
+	virtual ~ioasync_impl() {}
+	virtual ostream<byte>& output() = 0;
+	virtual bool failed() const = 0;
+};
+
+///
+/// Owner of the writer.
+/// It is a base class of \ref aofstream, so the writer is created before the stream, that wraps it.
+///
+class abstract_aofstream
+{
+protected:
+	abstract_aofstream(const char *filename, size_t block_size, size_t blocks):
+	  impl(ioasync_impl::create(filename, block_size, blocks)) {}
+
+	~abstract_aofstream() {
+		ioasync_impl::destroy(impl);
+	}
+
+	ioasync_impl *impl;
+
+private:
+	abstract_aofstream(const abstract_aofstream&);
+	abstract_aofstream& operator=(const abstract_aofstream&);
+};
+
+///
+/// Asynchronous output file stream.
+/// Data is written to the current block of \a block_size bytes; a filled block is passed
+///  to the writer thread and the next free block becomes current. write() waits only if all
+///  \a blocks blocks are being written (the disk is slower than the computation).
+/// Zero-copy output (acquire_write()) gives a part of the current block.
+/// Position can not be changed. eos() is true after close or a write error.
+/// close() writes the rest of data and waits for the writer; the destructor closes the stream too,
+///  but its errors are lost: check failed() after close().
+///
+template<typename T>
+class aofstream:
+	private abstract_aofstream,
+	public owrapblock<T, unsigned char>
+{
+public:
+
+	/// Constructor. Opens the file and starts the writer.
+	aofstream(const char *filename, size_t block_size = IOASYNC_BLOCK_SIZE, size_t blocks = IOASYNC_BLOCKS):
+	  abstract_aofstream(filename, std::max<size_t>(block_size / sizeof(T), 1) * sizeof(T), blocks),
+	  owrapblock<T, unsigned char>(impl->output())
+	  {}
+
+	//@{
+	/// Position in elements (it can not be changed).
+	virtual size_t pos() const { return this->_understream->pos() / sizeof(T); }
+	virtual size_t pos(size_t n) { return this->_understream->pos(n * sizeof(T)) / sizeof(T); }
+	//@}
+
+	/// Some data was not written to the file (valid after close()).
+	bool failed() const { return impl->failed(); }
+
+};
+
+} // namespace io
+
+#endif//_IO_ASYNC_
@@ -114,6 +114,33 @@ public:
 		x = (_buffer & bitmask(_bits++)) != 0;
 		return true;
 	}
+
+	/// Read bits: whole words are read from the underlying stream by blocks.
+	virtual size_t read(bool *x, size_t count) {
+		size_t i = 0;
+		// the rest of the current word
+		if(this->_bits != 0) {
+			while(i < count && this->_bits < this->maxbits())
+				x[i++] = (this->_buffer & this->bitmask(this->_bits++)) != 0;
+		}
+		B words[IOWRAP_BLOCK];
+		while(count - i >= this->maxbits()) {
+			size_t n = std::min((count - i) / this->maxbits(), IOWRAP_BLOCK);
+			size_t r = this->_understream->read(words, n);
+			for(size_t w = 0; w < r; w++) {
+				for(unsigned b = 0; b < this->maxbits(); b++)
+					x[i++] = (words[w] >> b) & 1;
+			}
+			if(r > 0) {
+				this->_buffer = words[r - 1];
+				this->_bits = this->maxbits();
+			}
+			if(r < n) return i;
+		}
+		// the beginning of the next word
+		while(i < count && get(x[i])) i++;
+		return i;
+	}
 }; // end of class ibitwrap
 
 
@@ -153,6 +180,32 @@ public:
 		return true;
 	}
 
+	/// Write bits: whole words are written to the underlying stream by blocks.
+	virtual size_t write(const bool *x, size_t count) {
+		size_t i = 0;
+		// complete the current word
+		while(i < count && this->_bits != 0) {
+			if(!put(x[i])) return i;
+			i++;
+		}
+		B words[IOWRAP_BLOCK];
+		while(count - i >= this->maxbits()) {
+			size_t n = std::min((count - i) / this->maxbits(), IOWRAP_BLOCK);
+			for(size_t w = 0; w < n; w++) {
+				B word = 0;
+				for(unsigned b = 0; b < this->maxbits(); b++)
+					word |= B(x[i + w * this->maxbits() + b] ? 1 : 0) << b;
+				words[w] = word;
+			}
+			size_t written = this->_understream->write(words, n);
+			i += written * this->maxbits();
+			if(written < n) return i;
+		}
+		// the beginning of the next word
+		while(i < count && put(x[i])) i++;
+		return i;
+	}
+
 	/// Flush bit buffer into output stream.
 	/// Attention! 
 	/// This function can cause null bits in the middle of stream, 
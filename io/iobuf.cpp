@@ -1,98 +1,173 @@
 #include "iobuf.h"
 using namespace io;
 
-#include <windows.h>
-
-#include <queue>
-using std::queue;
+#include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
-using std::auto_ptr;
+#include <mutex>
+#include <thread>
 
-template<typename T>
-struct membuf :
-    public auto_ptr<T>
-{
-public:
 
-    membuf() :
-        auto_ptr() {}
+typedef unsigned char byte;
+
+namespace {
 
-    membuf(size_t siz) :
-        auto_ptr(new T[siz]) {}
+/// Cache line size: indices of the producer and the consumer are kept in different lines.
+const size_t CACHE_LINE = 64;
 
-    membuf(T *header) :
-        auto_ptr(header) {}
+///
+/// Waiting for a condition, changed by another thread.
+/// The waiting thread checks the condition \a spin times, then parks on the condition variable.
+/// The notifying thread takes the mutex only if somebody is parked: it changes the condition
+///  and then reads the number of sleepers, the waiter increments it and then checks the condition
+///  (all sequentially consistent), so at least one of them sees the other.
+///
+class waiter
+{
+public:
+	waiter(): sleepers(0) {}
+
+	template<typename P>
+	void wait(size_t spin, P ready) {
+		for(size_t i = 0; i < spin; i++) {
+			if(ready()) return;
+			if(i % 64 == 63) std::this_thread::yield();
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		sleepers.fetch_add(1);
+		cond.wait(lock, ready);
+		sleepers.fetch_sub(1);
+	}
 
-    membuf(const membuf& x) :
-        auto_ptr(const_cast<membuf&>(x)) {}
+	/// Call after the condition is changed.
+	void notify() {
+		if(sleepers.load() == 0) return;
+		std::lock_guard<std::mutex> lock(mutex);
+		cond.notify_all();
+	}
 
-    operator T *() {
-        return get();
-    }
+private:
+	std::atomic<int> sleepers;
+	std::mutex mutex;
+	std::condition_variable cond;
+};
 
+struct block_t {
+	byte *data;
+	size_t fill_size;
 };
 
-template<typename T>
-class sync_queue
+}
+
+///
+/// Single-producer single-consumer ring of \a max_blocks preallocated blocks of \a bufsize bytes.
+/// The producer fills the block at \a tail and publishes it, the consumer reads the block at \a head
+///  and returns it. The producer waits while all blocks are filled (backpressure),
+///  the consumer waits while all blocks are free. Closing either side wakes both.
+///
+class spsc_ring
 {
 public:
-	sync_queue() {
-		InitializeCriticalSection(&critical_section);
+	spsc_ring(size_t bufsize_, size_t max_blocks, size_t spin_):
+	  bufsize(std::max<size_t>(bufsize_, 1)), size(std::max<size_t>(max_blocks, 1)), spin(spin_),
+	  memory(new byte[bufsize * size]), blocks(new block_t[size]),
+	  head(0), tail(0), _closed(false), head_cache(0), tail_cache(0)
+	{
+		for(size_t i = 0; i < size; i++) {
+			blocks[i].data = memory.get() + i * bufsize;
+			blocks[i].fill_size = 0;
+		}
 	}
 
-	~sync_queue() {
-		DeleteCriticalSection(&critical_section);
+	/// Producer: wait for a free block. Returns 0 if the ring was closed.
+	block_t *acquire_write() {
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if(t - head_cache == size) {
+			auto ready = [&]() {
+				head_cache = head.load();
+				return t - head_cache < size || closed();
+			};
+			if(!ready()) not_full.wait(spin, ready);
+		}
+		if(closed()) return 0;
+		block_t *block = &blocks[t % size];
+		block->fill_size = 0;
+		return block;
 	}
 
-	void push(T& x) {
-		enter();
-		impl.push(x);
-		leave();
+	/// Producer: publish the block, got by acquire_write().
+	void commit_write() {
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+		not_empty.notify();
 	}
 
-	T pop() {
-		enter();
-		T x = impl.front();
-		impl.pop();
-		leave();
-		return x;
+	/// Consumer: wait for a filled block. Returns 0 at the end of stream.
+	block_t *acquire_read() {
+		const size_t h = head.load(std::memory_order_relaxed);
+		if(h == tail_cache) {
+			auto ready = [&]() {
+				tail_cache = tail.load();
+				return h != tail_cache || closed();
+			};
+			if(!ready()) not_empty.wait(spin, ready);
+			// after closing the rest of data is still read
+			tail_cache = tail.load(std::memory_order_acquire);
+			if(h == tail_cache) return 0;
+		}
+		return &blocks[h % size];
 	}
 
-	size_t size() const {
-		return impl.size();
+	/// Consumer: return the block, got by acquire_read().
+	void commit_read() {
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+		not_full.notify();
 	}
 
-private:
-	std::queue<T> impl;
-	mutable CRITICAL_SECTION critical_section;
+	void close() {
+		_closed.store(true, std::memory_order_seq_cst);
+		not_empty.notify();
+		not_full.notify();
+	}
 
-	void enter() const {
-		EnterCriticalSection(&critical_section);
+	bool closed() const {
+		return _closed.load();
 	}
 
-	void leave() const {
-		LeaveCriticalSection(&critical_section);
+	/// No filled blocks (called by the consumer).
+	bool empty() const {
+		return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
 	}
-};
 
+	const size_t bufsize;
 
-typedef unsigned char byte;
+private:
+	const size_t size, spin;
+	std::unique_ptr<byte[]> memory;
+	std::unique_ptr<block_t[]> blocks;
 
-struct buffer_t {
-	membuf<byte> data;
-	size_t full_size;
-	size_t fill_size;
+	/// Counters of read and written blocks (block index is counter % size).
+	alignas(CACHE_LINE) std::atomic<size_t> head;
+	alignas(CACHE_LINE) std::atomic<size_t> tail;
+	alignas(CACHE_LINE) std::atomic<bool> _closed;
+
+	/// Last seen values of the other side's counter: the producer reads head, the consumer reads tail
+	///  only when the cached value says the ring is full (empty).
+	alignas(CACHE_LINE) size_t head_cache;
+	alignas(CACHE_LINE) size_t tail_cache;
+
+	waiter not_empty, not_full;
 };
 
-typedef sync_queue<buffer_t> bufqueue_t;
 
 class abstract_bufstream:
 	virtual public abstract_stream
 {
 public:
-	abstract_bufstream(bufqueue_t& filled_, bufqueue_t& free_, bool& closed):
-	  filled_buffers(filled_), free_buffers(free_), _closed(closed), _pos(0)
+	abstract_bufstream(spsc_ring& ring_):
+	  ring(ring_), _pos(0), _copied(0)
 	  {}
 
 	virtual size_t pos() const {
@@ -107,16 +182,25 @@ public:
 		throw "Not implemented";
 	}
 
-	void set_buffer_filled_event(HANDLE event_) {
-		buffer_filled_event = event_;
+	virtual void close() {
+		ring.close();
+	}
+
+	size_t copied() const {
+		return _copied.load(std::memory_order_relaxed);
 	}
 
 protected:
-	bufqueue_t& filled_buffers;
-	bufqueue_t& free_buffers;
-	bool& _closed;
+	/// Count bytes copied by read() or write(): only the stream's own thread changes the counter.
+	void count_copied(size_t n) {
+		_copied.store(_copied.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	spsc_ring& ring;
 	size_t _pos;
-	HANDLE buffer_filled_event;
+
+private:
+	std::atomic<size_t> _copied;
 };
 
 class obuf_uni:
@@ -124,142 +208,169 @@ class obuf_uni:
 	public abstract_bufstream
 {
 public:
-	obuf_uni(bufqueue_t& filled_, bufqueue_t& free_, bool& closed_, size_t bufsize_):
-	  abstract_bufstream(filled_, free_, closed_), bufsize(bufsize_)
+	obuf_uni(spsc_ring& ring_):
+	  abstract_bufstream(ring_), block(0), span(0)
 	{
 	}
 
 	virtual size_t write(const byte *data, size_t count);
 
+	virtual byte *acquire_write(byte *buf, size_t& count, size_t unit);
+	virtual size_t commit_write(const byte *data, size_t count);
+
 	virtual bool eos() const {
-		return _closed;
-	}
-	virtual size_t pos() const {
-		return _pos;
+		return ring.closed();
 	}
+
+	/// Publish the rest of data and close the stream.
 	virtual void close() {
-		_closed = true;
-		SetEvent(buffer_filled_event);
+		publish();
+		abstract_bufstream::close();
 	}
 
 private:
-	size_t bufsize;
+	/// Publish the current block (if it is not empty).
+	void publish();
+
+	/// Current block: it is filled by writes and published, when it is full or on close.
+	block_t *block;
+
+	/// Span, given by acquire_write() (a part of the current block).
+	byte *span;
 };
 
+void obuf_uni::publish() {
+	if(!block || block->fill_size == 0) return;
+	block = 0;
+	ring.commit_write();
+}
+
 size_t obuf_uni::write(const byte *data, size_t count) {
-	if(_closed) return 0;
 	size_t written = 0;
-	while(written < count) {
-		// get some free buffer
-		buffer_t buffer;
-		if(free_buffers.size() > 0) {
-			buffer = free_buffers.pop();
-		} else {
-			buffer.data = membuf<byte>(bufsize);
-			buffer.full_size = bufsize;
-		}
-
-		// fill it
-		size_t bytes_to_copy = min(count - written, buffer.full_size);
-		memcpy(buffer.data, data + written, bytes_to_copy);
-		buffer.fill_size = bytes_to_copy;
+	while(written < count && !ring.closed()) {
+		// get free block (waits, if the consumer is behind) and fill it
+		if(!block && !(block = ring.acquire_write())) break;
+		size_t bytes_to_copy = std::min(count - written, ring.bufsize - block->fill_size);
+		memcpy(block->data + block->fill_size, data + written, bytes_to_copy);
+		block->fill_size += bytes_to_copy;
 		written += bytes_to_copy;
-
-		// add to filled buffers
-		filled_buffers.push(buffer);
-		if(filled_buffers.size() == 1) {
-			SetEvent(buffer_filled_event);
-		}
+		if(block->fill_size == ring.bufsize) publish();
 	}
+	count_copied(written);
 	_pos += written;
 	return written;
 }
 
+byte *obuf_uni::acquire_write(byte *buf, size_t& count, size_t unit) {
+	span = 0;
+	if(ring.bufsize < unit) return buf;
+	// the rest of the current block is too small - publish it as is, so frames are not split
+	if(block && ring.bufsize - block->fill_size < unit) publish();
+	if(!block && !(block = ring.acquire_write())) return buf;
+	count = std::min(count, (ring.bufsize - block->fill_size) / unit * unit);
+	span = block->data + block->fill_size;
+	return span;
+}
+
+size_t obuf_uni::commit_write(const byte *data, size_t count) {
+	if(!span || data != span) return write(data, count);
+	span = 0;
+	block->fill_size += count;
+	_pos += count;
+	if(block->fill_size == ring.bufsize) publish();
+	return count;
+}
+
 class ibuf_uni:
 	public istream<byte>,
 	public abstract_bufstream
 {
 public:
-	ibuf_uni(bufqueue_t& filled_, bufqueue_t& free_, bool& closed_, size_t max_):
-	  abstract_bufstream(filled_, free_, closed_), buffer(), bufpos(0), max_buffers(max_)
+	ibuf_uni(spsc_ring& ring_):
+	  abstract_bufstream(ring_), block(0), bufpos(0), in_place(false)
 	{
 	}
-	
+
 	virtual size_t read(byte *data, size_t count);
 
-	virtual bool eos() const {
-		return _closed && buffer.data.get() == NULL && filled_buffers.size() == 0;
-	}
+	virtual const byte *acquire_read(byte *buf, size_t& count, size_t unit);
+	virtual void commit_read(size_t count);
 
-	virtual void close() {
-		_closed = true;
-		SetEvent(buffer_filled_event);
+	virtual bool eos() const {
+		return !block && ring.closed() && ring.empty();
 	}
 
 private:
-	buffer_t buffer;
+	block_t *block;
 	size_t bufpos;
-    size_t max_buffers;
+
+	/// The last span was returned in place.
+	bool in_place;
 };
 
 size_t ibuf_uni::read(byte *data, size_t count) {
 	size_t read = 0;
 	while(read < count) {
-		// if current buffer is empty
-		if(buffer.data == NULL) {
-			// if there are no filled buffers
-			while(filled_buffers.size() == 0) {
-				if(_closed) {
-					goto out;
-				}
-				// wait for the first one
-				WaitForSingleObject(buffer_filled_event, INFINITE);
-				ResetEvent(buffer_filled_event);
-			}
-			// get filled buffer
-			buffer = filled_buffers.pop();
+		// if there is no current block - wait for the filled one
+		if(!block) {
+			block = ring.acquire_read();
+			if(!block) break;
 			bufpos = 0;
 		}
 
 		// read from it
-		size_t bytes_to_copy = min(count - read, buffer.fill_size - bufpos);
-		memcpy(data + read, buffer.data + bufpos, bytes_to_copy);
+		size_t bytes_to_copy = std::min(count - read, block->fill_size - bufpos);
+		memcpy(data + read, block->data + bufpos, bytes_to_copy);
 		bufpos += bytes_to_copy;
 		read += bytes_to_copy;
 
-		// if whole buffer is read - free it
-		if(buffer.fill_size == bufpos) {
-			if(free_buffers.size() < max_buffers) {
-				// add it to free buffers
-				free_buffers.push(buffer);
-			} else {
-				// just free resources
-				buffer.data.reset();
-			}
+		// if whole block is read - return it to the producer
+		if(block->fill_size == bufpos) {
+			block = 0;
+			ring.commit_read();
 		}
 	}
-	out:
+	count_copied(read);
 	_pos += read;
 	return read;
 }
 
+const byte *ibuf_uni::acquire_read(byte *buf, size_t& count, size_t unit) {
+	if(!block) {
+		block = ring.acquire_read();
+		bufpos = 0;
+	}
+	in_place = block && block->fill_size - bufpos >= unit;
+	if(in_place) {
+		count = std::min(count, (block->fill_size - bufpos) / unit * unit);
+		return block->data + bufpos;
+	}
+	// end of stream or the unit is split between blocks - copy it
+	count = read(buf, std::min(count, unit));
+	return buf;
+}
+
+void ibuf_uni::commit_read(size_t count) {
+	if(!in_place) return;
+	in_place = false;
+	bufpos += count;
+	_pos += count;
+	if(block->fill_size == bufpos) {
+		block = 0;
+		ring.commit_read();
+	}
+}
+
 // unidirectional iobuf
 class iobuf_uni:
 	public iobuf_impl
 {
 public:
-	iobuf_uni():
-	  max_buffers(4), bufsize(500), _closed(false),
-	  _in(filled_buffers, free_buffers, _closed, max_buffers),
-	  _out(filled_buffers, free_buffers, _closed, bufsize)
+	iobuf_uni(size_t bufsize, size_t max_buffers, size_t spin):
+	  ring(bufsize, max_buffers, spin),
+	  _in(ring),
+	  _out(ring)
 	{
-		buffer_filled_event = CreateEvent(NULL, TRUE, FALSE, NULL);
-		_in.set_buffer_filled_event(buffer_filled_event);
-		_out.set_buffer_filled_event(buffer_filled_event);
-	}
-
-	~iobuf_uni() {
-		CloseHandle(buffer_filled_event);
 	}
 
 	virtual istream<byte>& input() {
@@ -269,21 +380,20 @@ public:
 		return _out;
 	}
 
-private:
-	int max_buffers;
-	size_t bufsize;
-	HANDLE buffer_filled_event;
+	virtual size_t bytes_copied() const {
+		return _in.copied() + _out.copied();
+	}
 
-	bufqueue_t filled_buffers;
-	bufqueue_t free_buffers;
-	bool _closed;
+private:
+	spsc_ring ring;
 
-	ibuf_uni _in;
-	obuf_uni _out;
+	/// Streams of the consumer and the producer are kept in different cache lines.
+	alignas(CACHE_LINE) ibuf_uni _in;
+	alignas(CACHE_LINE) obuf_uni _out;
 };
 
-iobuf_impl *iobuf_impl::create() {
-	return new iobuf_uni();
+iobuf_impl *iobuf_impl::create(size_t bufsize, size_t max_buffers, size_t spin) {
+	return new iobuf_uni(bufsize, max_buffers, spin);
 }
 
 void iobuf_impl::destroy(iobuf_impl *impl) {
@@ -3,26 +3,51 @@
 
 #include "io.h"
 #include "iowrap.h"
+#include <algorithm>
 
 namespace io {
 
+/// Block size (in bytes) and number of blocks of \ref memory_buffer by default.
+const size_t IOBUF_BLOCK_SIZE = 1 << 16;
+const size_t IOBUF_MAX_BLOCKS = 16;
+
+/// Number of checks before a waiting side of \ref memory_buffer parks (0 - park at once).
+const size_t IOBUF_SPIN = 1 << 10;
+
 class iobuf_impl
 {
 public:
 	typedef unsigned char byte;
-	static iobuf_impl *create();
+	static iobuf_impl *create(size_t bufsize, size_t max_buffers, size_t spin);
 	static void destroy(iobuf_impl *impl);
+	virtual ~iobuf_impl() {}
 	virtual istream<byte>& input() = 0;
 	virtual ostream<byte>& output() = 0;
+	virtual size_t bytes_copied() const = 0;
 };
 
+///
+/// Buffer between threads: data written to output() by one thread is read from input() by another.
+/// Data is passed in blocks of \a block_size bytes through a single-producer single-consumer ring
+///  of \a max_blocks blocks, allocated once: when all blocks are filled, the writer waits for the reader.
+/// A waiting side checks the ring \a spin times, then blocks (spin = 0 - blocking wait only).
+/// Writes are collected in the current block, it is published when it is full or on close(),
+///  so the reader gets small writes in whole blocks.
+/// Both sides support zero-copy spans (acquire_read(), acquire_write()): a span is a part of a block,
+///  the block size is rounded to whole elements, so frames written in spans are not split.
+/// Closing either side ends the stream: the reader gets the rest of data and eos, the writer stops.
+/// The buffer is meant for two threads. A single thread, that writes and then reads, sees its data
+///  only after the block is published, and it can not write more than \a max_blocks blocks
+///  before reading: the next write() waits for the reader forever.
+///
 template<typename T>
 class memory_buffer:
 	public buffer<T>
 {
 public:
-    memory_buffer():
-		impl(iobuf_impl::create()),
+    memory_buffer(size_t block_size = IOBUF_BLOCK_SIZE, size_t max_blocks = IOBUF_MAX_BLOCKS,
+		size_t spin = IOBUF_SPIN):
+		impl(iobuf_impl::create(std::max<size_t>(block_size / sizeof(T), 1) * sizeof(T), max_blocks, spin)),
 		_input(impl->input()),
 		_output(impl->output())
 	{
@@ -35,6 +60,10 @@ public:
     virtual istream<T>& input() { return _input; }
     virtual ostream<T>& output() { return _output; }
 
+    /// Number of bytes copied by read() and write() (spans, got by acquire_read() and acquire_write(),
+    ///  are not copied). Each side counts its own bytes, the sum is exact, when both sides are stopped.
+    size_t bytes_copied() const { return impl->bytes_copied(); }
+
 private:
 	typedef unsigned char byte;
 	iobuf_impl *impl;
@@ -50,11 +50,14 @@ abstract_fstream::abstract_fstream(
 }
 
 void abstract_fstream::close() {
+	// the destructor closes the file too
+	if(_data == INV_FILE) return;
 	try {
 		CLOSE_FILE(FH);
 	}
 	catch(...)
 	{ }
+	_data = INV_FILE;
 }
 
 #ifdef _IO_FILE_WINDOWS_
@@ -106,6 +109,11 @@ size_t abstract_fstream::_write(const void *buf, size_t bytes) {
 	return written;
 }
 
+bool abstract_fstream::flush() {
+	// WriteFile() is not buffered by the process
+	return _data != INV_FILE;
+}
+
 #endif // _IO_FILE_WINDOWS_
 
 #ifdef _IO_FILE_STDIO_
@@ -130,7 +138,7 @@ size_t abstract_fstream::skip(size_t N) {
 }
 
 bool abstract_fstream::eos() const {
-	return feof(FH) != 0;
+	return _data == INV_FILE || feof(FH) != 0;
 }
 
 size_t abstract_fstream::_read(void *buf, size_t bytes) {
@@ -141,6 +149,10 @@ size_t abstract_fstream::_write(const void *buf, size_t bytes) {
 	return fwrite(buf, 1, bytes, FH);
 }
 
+bool abstract_fstream::flush() {
+	return _data != INV_FILE && fflush(FH) == 0;
+}
+
 #endif // _IO_FILE_STDIO_
 
 
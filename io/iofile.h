@@ -45,6 +45,9 @@ public:
 	/// Close file stream.
 	virtual void close();
 
+	/// Pass buffered data to the file. Returns false on a write error.
+	bool flush();
+
 protected:
 
 	/// Protected constructor - only for inheritance
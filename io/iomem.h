@@ -7,6 +7,7 @@
 ///
 
 #include "io.h"
+#include <algorithm>
 
 namespace io {
 
@@ -101,6 +102,24 @@ public:
 		return eos() ? false : ((x = _data[_pos++]), true);
 	}
 
+	/// Read elements - one copy.
+	virtual size_t read(T *buf, size_t count) {
+		count = this->eos() ? 0 : std::min(count, this->_size - this->_pos);
+		std::copy(this->_data + this->_pos, this->_data + this->_pos + count, buf);
+		this->_pos += count;
+		return count;
+	}
+
+	/// Zero-copy input: elements are returned in place.
+	virtual const T *acquire_read(T *buf, size_t& count, size_t unit = 1) {
+		count = this->eos() ? 0 : std::min(count, this->_size - this->_pos);
+		return this->_data + this->_pos;
+	}
+
+	virtual void commit_read(size_t count) {
+		this->_pos += count;
+	}
+
 };
 
 ///
@@ -127,6 +146,27 @@ public:
 	virtual bool put(const T& x) {
 		return eos() ? false : ((_data[_pos++] = x), true);
 	}
+
+	/// Write elements - one copy.
+	virtual size_t write(const T *buf, size_t count) {
+		count = this->eos() ? 0 : std::min(count, this->_size - this->_pos);
+		std::copy(buf, buf + count, this->_data + this->_pos);
+		this->_pos += count;
+		return count;
+	}
+
+	/// Zero-copy output: elements are written in place (if there is room for \a unit elements).
+	virtual T *acquire_write(T *buf, size_t& count, size_t unit = 1) {
+		if(this->eos() || this->_size - this->_pos < unit) return buf;
+		count = std::min(count, (this->_size - this->_pos) / unit * unit);
+		return this->_data + this->_pos;
+	}
+
+	virtual size_t commit_write(const T *span, size_t count) {
+		if(span != this->_data + this->_pos) return ostream<T>::commit_write(span, count);
+		this->_pos += count;
+		return count;
+	}
 	
 };
 
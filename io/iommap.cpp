@@ -0,0 +1,85 @@
+#include "iommap.h"
+
+#ifdef _DEBUG
+#    include <stdio.h>
+#endif
+
+#if defined(WIN32) || defined(_WIN64)
+#    define _IO_MMAP_WINDOWS_
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include <limits>
+
+namespace io {
+
+file_mapping::file_mapping(const char *filename):
+  _view(0), _length(0), _handle(0)
+{
+	const char *error = 0;
+#ifdef _IO_MMAP_WINDOWS_
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	LARGE_INTEGER size;
+	if(file == INVALID_HANDLE_VALUE) {
+		error = "Can not open file";
+	}
+	else if(!GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart > std::numeric_limits<size_t>::max()) {
+		error = "Can not map file";
+	}
+	else if(size.QuadPart > 0) {
+		_handle = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+		_view = _handle ? (const unsigned char *)MapViewOfFile(_handle, FILE_MAP_READ, 0, 0, 0) : 0;
+		if(_view) _length = size_t(size.QuadPart);
+		else error = "Can not map file";
+	}
+	// the mapping keeps the file open
+	if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if(fd < 0) {
+		error = "Can not open file";
+	}
+	else if(fstat(fd, &st) != 0 || (unsigned long long)st.st_size > std::numeric_limits<size_t>::max()) {
+		error = "Can not map file";
+	}
+	else if(st.st_size > 0) {
+		void *p = mmap(0, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if(p != MAP_FAILED) {
+			_view = (const unsigned char *)p;
+			_length = size_t(st.st_size);
+			// read-ahead: files are usually read from the beginning to the end
+			madvise(p, _length, MADV_SEQUENTIAL);
+		}
+		else error = "Can not map file";
+	}
+	// the mapping keeps the file open
+	if(fd >= 0) ::close(fd);
+#endif
+	if(error) {
+		unmap();
+#ifdef _DEBUG
+		printf("file_mapping: %s '%s'\n", error, filename);
+#endif
+		throw error;
+	}
+}
+
+void file_mapping::unmap() {
+#ifdef _IO_MMAP_WINDOWS_
+	if(_view) UnmapViewOfFile(_view);
+	if(_handle) CloseHandle(_handle);
+#else
+	if(_view) munmap((void *)_view, _length);
+#endif
+	_view = 0;
+	_length = 0;
+	_handle = 0;
+}
+
+} // namespace io
@@ -0,0 +1,105 @@
+#ifndef _IO_MMAP_
+#define _IO_MMAP_
+
+///
+/// \file  iommap.h
+/// \brief Memory-mapped input file streams.
+///
+/// The whole file is mapped read-only, so reading does not copy data through the kernel
+///  and the elements can be got in place (acquire_read()). Position is random-access.
+///
+
+#include "iomem.h"
+
+namespace io {
+
+////////////////////////////////////////////////////////////////////////
+//                    MEMORY-MAPPED FILE CLASSES                      //
+////////////////////////////////////////////////////////////////////////
+
+///
+/// Read-only mapping of a whole file.
+/// The mapping is advised for sequential access (read-ahead), random access is allowed too.
+/// Empty file is mapped to the null pointer with zero size.
+///
+
+class file_mapping
+{
+public:
+
+	/// Map file. Throws if the file can not be opened or mapped.
+	file_mapping(const char *filename);
+
+	/// Destructor - unmaps the file.
+	~file_mapping() { unmap(); }
+
+	/// Mapped bytes.
+	const unsigned char *data() const { return _view; }
+
+	/// File size in bytes.
+	size_t size() const { return _length; }
+
+	/// Unmap the file. Pointers to the data become invalid.
+	void unmap();
+
+private:
+
+	const unsigned char *_view;
+	size_t _length;
+
+	/// Mapping handle (only on Windows).
+	void *_handle;
+
+	file_mapping(const file_mapping&);
+	file_mapping& operator=(const file_mapping&);
+};
+
+///
+/// Memory-mapped input file stream.
+/// Raw file of elements T (as written by ofstream<T>), starting from \a offset bytes.
+/// Works as imstream over the mapping: read() is one copy, acquire_read() is zero-copy,
+///  pos() and skip() do not touch the file.
+///
+
+template<typename T>
+class immstream:
+	private file_mapping,
+	public imstream<T>
+{
+public:
+
+	/// Constructor. Maps the file.
+	immstream(const char *filename, size_t offset = 0):
+	  file_mapping(filename),
+	  imstream<T>(
+		reinterpret_cast<const T *>(file_mapping::data() + std::min(offset, file_mapping::size())),
+		(file_mapping::size() - std::min(offset, file_mapping::size())) / sizeof(T))
+	  {}
+
+	/// Stream size (in elements).
+	using abstract_mstream<T>::size;
+
+	//@{
+	/// Random-access position, stops at the end of the stream.
+	virtual size_t pos() const { return this->_pos; }
+	virtual size_t pos(size_t newpos) {
+		this->_pos = std::min(newpos, this->_size);
+		return this->_pos;
+	}
+	virtual size_t skip(size_t N) {
+		this->_pos += std::min(N, this->_size - this->_pos);
+		return this->_pos;
+	}
+	//@}
+
+	/// Close stream and unmap the file.
+	virtual void close() {
+		imstream<T>::close();
+		unmap();
+	}
+
+};
+
+} // namespace io
+
+#endif//_IO_MMAP_
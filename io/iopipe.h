@@ -0,0 +1,95 @@
+#ifndef _IO_PIPE_
+#define _IO_PIPE_
+
+///
+/// \file  iopipe.h
+/// \brief Pipeline of filters, executed in separate threads.
+///
+/// Each stage is a \ref filter running in its own thread (std::thread).
+/// Stages are connected by bounded buffers (\ref memory_buffer), so a fast stage
+///  waits for a slow one instead of accumulating data.
+///
+
+#include "io.h"
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace io {
+
+///
+/// Pipelined executor.
+/// run() starts a stage; wait() waits for all stages and rethrows the first exception of a stage.
+///
+/// When a stage finishes or fails, its input and output are closed: the next stage gets
+///  the end of stream, and the previous stage does not wait for the space in the buffer forever
+///  (a stage may stop before the end of its input).
+///
+class pipeline
+{
+	/// Stage filter type - stream types are deduced from the streams only
+	///  (a filter can implement several filter<> interfaces).
+	template<typename T1, typename T2>
+	struct stage_filter { typedef filter<T1, T2> type; };
+
+public:
+
+	pipeline() {}
+
+	/// Waits for all stages (exceptions of stages are dropped).
+	~pipeline() {
+		join();
+	}
+
+	/// Start filter \a f in a new thread: f.execute(in, out).
+	/// Filter and streams should live until wait().
+	template<typename T1, typename T2>
+	void run(const typename stage_filter<T1, T2>::type& f, istream<T1>& in, ostream<T2>& out) {
+		_threads.push_back(std::thread([this, &f, &in, &out]() {
+			try {
+				f.execute(in, out);
+			}
+			catch(...) {
+				fail(std::current_exception());
+			}
+			in.close();
+			out.close();
+		}));
+	}
+
+	/// Wait for all stages.
+	void wait() {
+		join();
+		if(_error) {
+			std::exception_ptr e = _error;
+			_error = nullptr;
+			std::rethrow_exception(e);
+		}
+	}
+
+private:
+
+	void join() {
+		for(size_t i = 0; i < _threads.size(); i++) {
+			if(_threads[i].joinable()) _threads[i].join();
+		}
+		_threads.clear();
+	}
+
+	void fail(std::exception_ptr e) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(!_error) _error = e;
+	}
+
+	std::vector<std::thread> _threads;
+	std::exception_ptr _error;
+	std::mutex _mutex;
+
+	pipeline(const pipeline&);
+	pipeline& operator=(const pipeline&);
+};
+
+} // namespace io
+
+#endif//_IO_PIPE_
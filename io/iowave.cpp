@@ -1,5 +1,6 @@
 #include "iowave.h"
 #include <limits>
+#include <string.h>
 
 namespace io {
 
@@ -44,4 +45,55 @@ basic_iwstream::basic_iwstream(const char *file):
 
 }
 
+namespace {
+
+/// Little-endian value from the mapping.
+template<typename T>
+T get_value(const unsigned char *p) {
+	T x;
+	memcpy(&x, p, sizeof(T));
+	return x;
+}
+
+}
+
+basic_iwmstream::basic_iwmstream(const char *file):
+	_map(file), _samples(0), _count(0), M(0), B(0), F(0), _float(false), _pos(0), _closed(false)
+{
+	typedef unsigned int dword;
+	const byte *p = _map.data(), *end = p + _map.size();
+	if(end - p < 12 || get_value<dword>(p) != 0x46464952) // "RIFF"
+		throw "Not a RIFF file";
+	if(get_value<dword>(p + 8) != 0x45564157) // "WAVE"
+		throw "Not a WAVE file";
+
+	// go through chunks (chunk id, chunk size, data padded to even size)
+	size_t N = 0;
+	for(p += 12; end - p >= 8; ) {
+		const dword id = get_value<dword>(p);
+		const size_t size = std::min<size_t>(get_value<dword>(p + 4), end - p - 8);
+		p += 8;
+		if(id == 0x20746D66) { // "fmt "
+			if(size < 16)
+				throw "Can't read from file";
+			const unsigned short code = get_value<unsigned short>(p); // compression code
+			if(code != 1 && code != 3) // PCM and IEEE float
+				throw "Don't support compressed wave-files";
+			_float = code == 3;
+			M = get_value<unsigned short>(p + 2); // number of channels
+			F = get_value<dword>(p + 4); // sample rate
+			B = (get_value<unsigned short>(p + 14) + 7) / 8; // bits per sample -> bytes per sample
+		} else if(id == 0x61746164) { // "data"
+			_samples = p; // sample section in the mapping (its size is limited by the file)
+			N = size;
+			break;
+		}
+		p += std::min<size_t>(size + size % 2, end - p); // skip this chunk
+	}
+
+	if(!F || !N || !M || !B) 
+		throw "Key fields of wave-file were not read";
+	_count = N / (M * B);
+}
+
 } // namespace spl
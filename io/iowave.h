@@ -2,10 +2,25 @@
 #define _IO_WAVE_
 
 #include "iofile.h"
+#include "iommap.h"
+#include <algorithm>
 #include <limits>
+#include <stdint.h>
+#include <string.h>
 
 namespace io {
 
+/// Number of raw values, read by \ref iwstream at once.
+const size_t IOWAVE_BLOCK = 4096;
+
+/// Conversion of raw integer value to [-1, 1).
+template<typename S, typename T>
+inline void wave_sample_to_float(const S& x, T& y) {
+    S smin = std::numeric_limits<S>::min();
+    S smax = std::numeric_limits<S>::max();
+    y = (2 * T(x) - (T(smax) + 1 + smin)) / (T(smax) + 1 - smin);
+}
+
 class basic_iwstream
 {
 protected:
@@ -33,11 +48,34 @@ protected:
         return true;
     }
 
+    // Function that reads up to count samples (sums across channels) by blocks of raw values.
+    // Reading stops at the end of samples section. Requires M <= IOWAVE_BLOCK.
+    template<typename S, typename T>
+    size_t read_slices(T *x, size_t count) {
+        S raw[IOWAVE_BLOCK];
+        const size_t slice = M * sizeof(S);
+        const size_t end = _base + N;
+        const size_t left = _f.pos() < end ? (end - _f.pos()) / slice : 0;
+        const size_t per_block = IOWAVE_BLOCK / M;
+        count = std::min(count, left);
+        size_t done = 0;
+        while (done < count) {
+            size_t n = std::min(count - done, per_block);
+            size_t r = _f.read((byte*)raw, n * slice) / slice;
+            for (size_t i = 0; i < r; i++) {
+                S y = 0;
+                for (int c = 0; c < M; c++) y += raw[i * M + c];
+                convert_sample(y, x[done + i]);
+            }
+            done += r;
+            if (r < n) break;
+        }
+        return done;
+    }
+
     template<typename S, typename T>
     void convert_sample_to_float(const S& x, T& y) {
-        S smin = std::numeric_limits<S>::min();
-        S smax = std::numeric_limits<S>::max();
-        y = (2 * T(x) - (T(smax) + 1 + smin)) / (T(smax) + 1 - smin);
+        wave_sample_to_float(x, y);
     }
 
     template<typename S>
@@ -90,6 +128,17 @@ public:
         }
     }
 
+	/// Read samples by blocks.
+	virtual size_t read(T *buf, size_t count) {
+        if (M > IOWAVE_BLOCK) return istream<T>::template read<T>(buf, count);
+        switch (B) {
+        case 1: return read_slices<byte>(buf, count);
+        case 2: return read_slices<short>(buf, count);
+        case 4: return read_slices<long>(buf, count);
+        default: return 0;
+        }
+    }
+
 	virtual size_t pos() const { return (_f.pos() - _base) / M; }
 	virtual size_t pos(size_t n) { return (_f.pos(_base + n*M) - _base) / M; }
 	virtual size_t skip(size_t n) { return _f.skip(n*M), pos(); }
@@ -101,6 +150,117 @@ public:
 
 };
 
+class basic_iwmstream
+{
+protected:
+    basic_iwmstream(const char *file);
+
+    typedef unsigned char byte;
+    file_mapping _map;
+
+    // Function that converts up to count samples (sums across channels) right from the mapping.
+    template<typename S, typename T>
+    size_t read_slices(T *x, size_t count) {
+        count = std::min(count, left());
+        const byte *p = _samples + _pos * M * sizeof(S);
+        for (size_t i = 0; i < count; i++) {
+            S y = 0;
+            for (unsigned c = 0; c < M; c++, p += sizeof(S)) {
+                S v;
+                memcpy(&v, p, sizeof(S)); // samples section may be unaligned
+                y += v;
+            }
+            convert_sample(y, x[i]);
+        }
+        _pos += count;
+        return count;
+    }
+
+    template<typename S, typename T>
+    static void convert_sample(const S& x, T& y) { wave_sample_to_float(x, y); }
+
+    // IEEE float values are not scaled.
+    template<typename T>
+    static void convert_sample(const float& x, T& y) { y = T(x); }
+    template<typename T>
+    static void convert_sample(const double& x, T& y) { y = T(x); }
+
+    size_t left() const { return _closed ? 0 : _count - _pos; }
+
+    // WAVE FILE FORMAT
+    const byte *_samples; ///< samples section in the mapping
+    size_t _count; ///< number of samples (slices of M values)
+    unsigned M; ///< number of channels
+    unsigned B; ///< number of bytes in one value
+    unsigned long F; ///< sampling frequency
+    bool _float; ///< values are IEEE float
+
+    size_t _pos; ///< current sample
+    bool _closed;
+};
+
+/// 
+/// Memory-mapped wave file stream.
+/// Same as \ref iwstream, but the file is mapped: samples are converted right from the mapping,
+///  position is random-access. Mono IEEE float files of type T are read in place (acquire_read()).
+/// Supports PCM (8, 16, 32 bit) and IEEE float (32, 64 bit) files.
+///
+
+template<typename T>
+class iwmstream:
+	public istream<T>,
+    private basic_iwmstream
+{
+public:
+	/// Constructor. Get wav-file path.
+    iwmstream(const char *file): basic_iwmstream(file) {}
+
+	/// Get next sample.
+	/// In multi-channel signals (e.g. stereo) this function gets sum of values for current sample.
+	virtual bool get(T& x) { return read(&x, 1) == 1; }
+
+	/// Read samples - one conversion from the mapping.
+	virtual size_t read(T *buf, size_t count) {
+        switch (B) {
+        case 1: return _float ? 0 : read_slices<byte>(buf, count);
+        case 2: return _float ? 0 : read_slices<short>(buf, count);
+        case 4: return _float ? read_slices<float>(buf, count) : read_slices<int32_t>(buf, count);
+        case 8: return _float ? read_slices<double>(buf, count) : 0;
+        default: return 0;
+        }
+    }
+
+	/// Zero-copy input, if the samples section is an array of T.
+	virtual const T *acquire_read(T *buf, size_t& count, size_t unit = 1) {
+        if (!in_place()) return istream<T>::acquire_read(buf, count, unit);
+        count = std::min(count, left());
+        return reinterpret_cast<const T *>(_samples) + _pos;
+    }
+
+	virtual void commit_read(size_t count) {
+        if (in_place()) _pos += count;
+    }
+
+	virtual size_t pos() const { return _pos; }
+	virtual size_t pos(size_t n) { return _pos = std::min(n, _count); }
+	virtual size_t skip(size_t n) { return _pos += std::min(n, _count - _pos); }
+	virtual bool eos() const { return left() == 0; }
+	virtual void close() { _closed = true; _map.unmap(); }
+
+	/// Get sampling frequency.
+	unsigned long freq() const { return F; }
+
+	/// Number of samples.
+	size_t size() const { return _count; }
+
+private:
+    bool in_place() const {
+        return _float && M == 1 && B == sizeof(T) && std::numeric_limits<T>::is_iec559
+            && (size_t)_samples % sizeof(T) == 0;
+    }
+
+};
+
 } // namespace spl
 
 #endif//_IO_WAVE_
@@ -16,10 +16,14 @@
 ///
 
 #include "io.h"
+#include <algorithm>
 
 
 namespace io {
 
+/// Number of elements, converted by element wrappers (\ref iwrapelem, \ref owrapelem) at once.
+const size_t IOWRAP_BLOCK = 1024;
+
 ////////////////////////////////////////////////////////////////////////
 //                        BIT STREAM CLASSES                          //
 ////////////////////////////////////////////////////////////////////////
@@ -105,11 +109,30 @@ public:
 		return r;
 	}
 
+	/// istream::read() implementation in \ref iwrapelem - read wrapped stream by blocks and convert them.
+	virtual size_t read(T *buf, size_t count) {
+		T2 block[IOWRAP_BLOCK];
+		size_t done = 0;
+		while(done < count) {
+			size_t n = std::min(count - done, IOWRAP_BLOCK);
+			size_t r = this->_understream->read(block, n);
+			convert_block(block, buf + done, r);
+			done += r;
+			if(r < n) break;
+		}
+		return done;
+	}
+
 protected:
 
     virtual void convert(const T2& x, T& y) const {
         _convert(x, y);
     }
+
+    /// Block conversion. Can be redefined to avoid virtual call per element.
+    virtual void convert_block(const T2 *x, T *y, size_t count) const {
+        for(size_t i = 0; i < count; i++) convert(x[i], y[i]);
+    }
     
     convert_func _convert;
 	
@@ -136,6 +159,80 @@ public:
 		return read_translated;
 	}
 
+	/// Spans of the wrapped stream, reinterpreted.
+	virtual const T *acquire_read(T *buf, size_t& count, size_t unit = 1) {
+		size_t count_translated = count * sizeof(T) / sizeof(T2);
+		const T2 *span = this->_understream->acquire_read(reinterpret_cast<T2 *>(buf), count_translated,
+			unit * sizeof(T) / sizeof(T2));
+		count = count_translated * sizeof(T2) / sizeof(T);
+		return reinterpret_cast<const T *>(span);
+	}
+
+	virtual void commit_read(size_t count) {
+		this->_understream->commit_read(count * sizeof(T) / sizeof(T2));
+	}
+
+};
+
+/// Input wrapper, that passes only every \a hop-th frame of \a frame elements 
+///  (frames 0, hop, 2*hop, ...) of the wrapped stream; other frames are read and dropped.
+/// Used to decimate frame streams (spectrum, mask) in time.
+/// Position is counted in elements of the decimated stream, from the wrapper creation.
+template<typename T>
+class iwrapdecimate:
+	public iwrap<T>
+{
+public:
+
+	iwrapdecimate(istream<T>& in_str, size_t frame, size_t hop):
+	  iwrap<T>(in_str), _frame(frame), _drop(frame * (hop - 1)), _pos(0), _done(0) {}
+
+	//@{
+	/// Position in decimated elements. It moves only forward: skipped elements are read and dropped.
+	virtual size_t pos() const { return _done; }
+	virtual size_t pos(size_t newpos) {
+		if(newpos < _done) throw "Not implemented";
+		T tmp[256];
+		while(_done < newpos) {
+			size_t n = std::min(newpos - _done, sizeof(tmp) / sizeof(T));
+			if(read(tmp, n) < n) break;
+		}
+		return _done;
+	}
+	//@}
+
+	virtual size_t read(T *buf, size_t count) {
+		size_t done = 0;
+		while(done < count) {
+			// frame passed - drop next (hop - 1) frames
+			if(_pos == _frame) {
+				if(!drop()) break;
+				_pos = 0;
+			}
+			size_t n = std::min(count - done, _frame - _pos);
+			size_t r = this->_understream->read(buf + done, n);
+			done += r;
+			_pos += r;
+			if(r < n) break;
+		}
+		_done += done;
+		return done;
+	}
+
+private:
+
+	bool drop() {
+		T tmp[256];
+		for(size_t left = _drop; left > 0; ) {
+			size_t n = std::min(left, sizeof(tmp) / sizeof(T));
+			size_t r = this->_understream->read(tmp, n);
+			left -= r;
+			if(r < n) return false;
+		}
+		return true;
+	}
+
+	size_t _frame, _drop, _pos, _done;
 };
 
 
@@ -178,12 +275,32 @@ public:
 		convert(x, y);
 		return _understream->put(y);
 	}
+
+	/// ostream::write() implementation in \ref owrapelem - convert by blocks and write them to wrapped stream.
+	virtual size_t write(const T *buf, size_t count) {
+		T2 block[IOWRAP_BLOCK];
+		size_t done = 0;
+		while(done < count) {
+			size_t n = std::min(count - done, IOWRAP_BLOCK);
+			convert_block(buf + done, block, n);
+			size_t w = this->_understream->write(block, n);
+			done += w;
+			if(w < n) break;
+		}
+		return done;
+	}
+
 private:
 
     virtual void convert(const T& x, T2& y) const {
         _convert(x, y);
     }
 
+    /// Block conversion. Can be redefined to avoid virtual call per element.
+    virtual void convert_block(const T *x, T2 *y, size_t count) const {
+        for(size_t i = 0; i < count; i++) convert(x[i], y[i]);
+    }
+
     convert_func _convert;
 
 	static void default_convert(const T& x, T2& y) {
@@ -209,6 +326,21 @@ public:
 		return written_translated;
 	}
 
+	/// Spans of the wrapped stream, reinterpreted.
+	virtual T *acquire_write(T *buf, size_t& count, size_t unit = 1) {
+		size_t count_translated = count * sizeof(T) / sizeof(T2);
+		T2 *span = this->_understream->acquire_write(reinterpret_cast<T2 *>(buf), count_translated,
+			unit * sizeof(T) / sizeof(T2));
+		count = count_translated * sizeof(T2) / sizeof(T);
+		return reinterpret_cast<T *>(span);
+	}
+
+	virtual size_t commit_write(const T *span, size_t count) {
+		size_t written = this->_understream->commit_write(reinterpret_cast<const T2 *>(span),
+			count * sizeof(T) / sizeof(T2));
+		return written * sizeof(T2) / sizeof(T);
+	}
+
 };
 
 } // namespace io
@@ -1,14 +1,22 @@
 #ifndef _SPL_THREADS_
 #define _SPL_THREADS_
 
-#include <windows.h>
 #include "../core/spl_types.h"
-#include "../io/iobuf.h"
-#include "../io/iomem.h"
-#include "io.h"
+#include "../core/config.h"
+#include "../io/io.h"
 
 namespace spl {
 
+	///
+	///     :  ->  ->  (-> ).
+	///      ,    .
+	///
+	/// \a F1, \a F2 -   ;   (K , )
+	///     ,   [F1, Nh * F2].
+	///  -       (0 - ).
+	///     \a vocal,     
+	///  (    ).
+	///
 	void spl_pitch_in_threads(
 		int K,
 		double sample_rate,
@@ -16,36 +24,8 @@ namespace spl {
 		freq_t F2,
 		io::istream<signal_t>& in_str,
 		io::ostream<freq_t>& out_str,
-		double window_error
+		double window_error,
+		const vocal_params_t *vocal = 0
 	);
-
-	struct spec_params {
-		int num_freqs;				 ///<   
-		const freq_t *freqs;         ///<  
-		io::istream<signal_t> *s;    ///<   ()
-		io::ostream<spectrum_t> *sp; ///<   ()
-		freq_t sampling_freq;        ///<  
-		double window_error;         ///< ,    ( )
-	};
-
-
-	struct mask_params {
-		int num_freqs;				 ///<   
-		const freq_t *freqs;               ///<  
-		io::istream<spectrum_t> *sp; ///<    ()
-		io::ostream<mask_t> *m;		 ///<   ()
-		double window_error;         ///< ,    ( )
-	};
-
-
-	struct pitch_params {
-		int num_freqs;				 ///<   
-		const freq_t *freqs;               ///<  
-		io::istream<mask_t> *m;		 ///<   ()
-		io::ostream<freq_t> *p;	     ///<   (  )
-		freq_t min_pitch;			 ///<    
-		freq_t max_pitch;		     ///<    
-		double window_error;         ///< ,    ( )
-	};
 }
-#endif//_SPL_THREADS_
\ No newline at end of file
+#endif//_SPL_THREADS_
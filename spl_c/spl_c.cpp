@@ -5,8 +5,10 @@
 #include "../core/mask.h"
 #include "../core/vocal.h"
 #include "../io/iobit.h"
+#include "../io/ioasync.h"
 #include "../io/iofile.h"
 #include "../io/iomem.h"
+#include "../io/iommap.h"
 #include "../io/iowave.h"
 
 //
@@ -53,6 +55,15 @@ static inline size_t _spl_spectrum_calc(int num_freqs, const freq_t *freqs, io::
     return calc.execute(s, sp);
 }
 
+// the last blocks are written on close: 0 if the spectrum file is incomplete
+static inline size_t _spl_spectrum_calc_file(int num_freqs, const freq_t *freqs, io::istream<signal_t>& s, const char *spectrum_path, freq_t sample_freq, double window_error)
+{
+    io::aofstream<spectrum_t> sp(spectrum_path);
+    size_t n = _spl_spectrum_calc(num_freqs, freqs, s, sp, sample_freq, window_error);
+    sp.close();
+    return sp.failed() ? 0 : n;
+}
+
 size_t C_CALL spl_spectrum_calc_mem(int num_freqs, const freq_t *freqs, int num_samples, const signal_t *signal, freq_t sampling_freq, spectrum_t *spectrum, double window_error)
 {
     io::imstream<signal_t> s(signal, num_samples);
@@ -62,16 +73,14 @@ size_t C_CALL spl_spectrum_calc_mem(int num_freqs, const freq_t *freqs, int num_
 
 size_t C_CALL spl_spectrum_calc_bin_file(int num_freqs, const freq_t *freqs, const char *signal_path, freq_t sampling_freq, const char *spectrum_path, double window_error)
 {
-    io::ifstream<signal_t> s(signal_path);
-    io::ofstream<spectrum_t> sp(spectrum_path);
-    return _spl_spectrum_calc(num_freqs, freqs, s, sp, sampling_freq, window_error);
+    io::immstream<signal_t> s(signal_path);
+    return _spl_spectrum_calc_file(num_freqs, freqs, s, spectrum_path, sampling_freq, window_error);
 }
 
 size_t C_CALL spl_spectrum_calc_wav_file(int num_freqs, const freq_t *freqs, const char *signal_path, const char *spectrum_path, double window_error)
 {
-    io::iwstream<signal_t> s(signal_path);
-    io::ofstream<spectrum_t> sp(spectrum_path);
-    return _spl_spectrum_calc(num_freqs, freqs, s, sp, s.freq(), window_error);
+    io::iwmstream<signal_t> s(signal_path);
+    return _spl_spectrum_calc_file(num_freqs, freqs, s, spectrum_path, s.freq(), window_error);
 }
 
 
@@ -96,14 +105,14 @@ size_t C_CALL spl_freq_mask_calc_mem(int num_freqs, const freq_t *freqs, int num
 
 size_t C_CALL spl_freq_mask_calc_bin_file(int num_freqs, const freq_t *freqs, const char *spectrum_path, const char *freq_mask_path, double window_error)
 {
-    io::ifstream<spectrum_t> sp(spectrum_path);
+    io::immstream<spectrum_t> sp(spectrum_path);
     io::ofstream<mask_t> m(freq_mask_path);
     return _spl_freq_mask_calc(num_freqs, freqs, sp, m, window_error);
 }
 
 size_t C_CALL spl_freq_mask_calc_bit_file(int num_freqs, const freq_t *freqs, const char *spectrum_path, const char *freq_mask_path, double window_error)
 {
-    io::ifstream<spectrum_t> sp(spectrum_path);
+    io::immstream<spectrum_t> sp(spectrum_path);
     io::ofstream<unsigned char> u(freq_mask_path);
     io::obitwrap8 m(u);
     return _spl_freq_mask_calc(num_freqs, freqs, sp, m, window_error);
@@ -142,14 +151,14 @@ size_t C_CALL spl_pitch_calc_mem(int num_freqs, const freq_t *freqs, int num_sam
 
 size_t C_CALL spl_pitch_calc_bin_file(int num_freqs, const freq_t *freqs, const char *freq_mask_path, const char *pitch_path, freq_t min_pitch, freq_t max_pitch, double window_error)
 {
-    io::ifstream<mask_t> m(freq_mask_path);
+    io::immstream<mask_t> m(freq_mask_path);
     io::ofstream<freq_t> p(pitch_path);
     return _spl_pitch_calc(num_freqs, freqs, m, p, min_pitch, max_pitch, window_error);
 }
 
 size_t C_CALL spl_pitch_calc_bit_file(int num_freqs, const freq_t *freqs, const char *freq_mask_path, const char *pitch_path, freq_t min_pitch, freq_t max_pitch, double window_error)
 {
-    io::ifstream<unsigned char> u(freq_mask_path);
+    io::immstream<unsigned char> u(freq_mask_path);
     io::ibitwrap8 m(u);
     io::ofstream<freq_t> p(pitch_path);
     return _spl_pitch_calc(num_freqs, freqs, m, p, min_pitch, max_pitch, window_error);
@@ -4,9 +4,16 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/* SPL_FLOAT - single precision build, must match the library build */
+#ifdef SPL_FLOAT
+typedef float signal_t;
+typedef double freq_t;
+typedef float spectrum_t;
+#else
 typedef double signal_t;
 typedef double freq_t;
 typedef double spectrum_t;
+#endif
 typedef bool mask_t;
 
 #ifdef _MSC_VER
@@ -4,14 +4,15 @@
 #include "../core/mask.h"
 #include "../core/vocal.h"
 #include "../io/iobit.h"
+#include "../io/ioasync.h"
 #include "../io/iofile.h"
 #include "../io/iomem.h"
+#include "../io/iommap.h"
 #include "../io/iowave.h"
 #include "../io/iobuf.h"
+#include "../io/iopipe.h"
 #include "../io/io.h"
 
-#include <thread>
-
 NAMESPACE_SPL_BEGIN;
 
 spl_calc_t::spl_calc_t() : p(spl_params_t::DEFAULT)
@@ -69,24 +70,29 @@ size_t spl_calc_t::calc_spectrum(int num_samples, freq_t sample_freq, const sign
 {
     io::imstream<signal_t> s(signal, num_samples);
     io::omstream<spectrum_t> sp(spectrum, num_samples * sc->size());
-    spl::spectrum_calculator calc(*sc, sample_freq, p.spectrum.ksi);
+    spl::spectrum_calculator calc(*sc, sample_freq, p.spectrum.ksi, spl::CONV_SIZ_AUTO, num_samples);
     return calc.execute(s, sp);
 }
 
 size_t spl_calc_t::calc_spectrum_bin(freq_t sample_freq, const char *signal_path, const char *spectrum_path) const
 {
-    io::ifstream<signal_t> s(signal_path);
-    io::ofstream<spectrum_t> sp(spectrum_path);
+    io::immstream<signal_t> s(signal_path);
+    io::aofstream<spectrum_t> sp(spectrum_path);
     spl::spectrum_calculator calc(*sc, sample_freq, p.spectrum.ksi);
-    return calc.execute(s, sp);
+    size_t n = calc.execute(s, sp);
+    // the last blocks are written on close: 0 if the spectrum file is incomplete
+    sp.close();
+    return sp.failed() ? 0 : n;
 }
 
 size_t spl_calc_t::calc_spectrum_wav(const char *signal_path, const char *spectrum_path) const
 {
-    io::iwstream<signal_t> s(signal_path);
-    io::ofstream<spectrum_t> sp(spectrum_path);
+    io::iwmstream<signal_t> s(signal_path);
+    io::aofstream<spectrum_t> sp(spectrum_path);
     spl::spectrum_calculator calc(*sc, s.freq(), p.spectrum.ksi);
-    return calc.execute(s, sp);
+    size_t n = calc.execute(s, sp);
+    sp.close();
+    return sp.failed() ? 0 : n;
 }
 
 size_t spl_calc_t::calc_freq_mask(int num_samples, const spectrum_t *spectrum, mask_t *freq_mask) const
@@ -99,7 +105,7 @@ size_t spl_calc_t::calc_freq_mask(int num_samples, const spectrum_t *spectrum, m
 
 size_t spl_calc_t::calc_freq_mask_bin(const char *spectrum_path, const char *freq_mask_path) const
 {
-    io::ifstream<spectrum_t> sp(spectrum_path);
+    io::immstream<spectrum_t> sp(spectrum_path);
     io::ofstream<mask_t> m(freq_mask_path);
     spl::freq_mask_calculator calc(*sc, p.freq_mask);
     return calc.execute(sp, m);
@@ -107,7 +113,7 @@ size_t spl_calc_t::calc_freq_mask_bin(const char *spectrum_path, const char *fre
 
 size_t spl_calc_t::calc_freq_mask_bit(const char *spectrum_path, const char *freq_mask_path) const
 {
-    io::ifstream<spectrum_t> sp(spectrum_path);
+    io::immstream<spectrum_t> sp(spectrum_path);
     io::ofstream<unsigned char> u(freq_mask_path);
     io::obitwrap8 m(u);
     spl::freq_mask_calculator calc(*sc, p.freq_mask);
@@ -125,7 +131,7 @@ size_t spl_calc_t::calc_pitch(int num_samples, const mask_t *freq_mask, freq_t *
 
 size_t spl_calc_t::calc_pitch_bin(const char *freq_mask_path, const char *pitch_path) const
 {
-    io::ifstream<mask_t> ms(freq_mask_path);
+    io::immstream<mask_t> ms(freq_mask_path);
     io::ofstream<freq_t> ps(pitch_path);
 
     spl::pitch_calculator calc(*sc, p.freq_mask, p.pitch);
@@ -135,7 +141,7 @@ size_t spl_calc_t::calc_pitch_bin(const char *freq_mask_path, const char *pitch_
 
 size_t spl_calc_t::calc_pitch_bit(const char *freq_mask_path, const char *pitch_path) const
 {
-    io::ifstream<unsigned char> u(freq_mask_path);
+    io::immstream<unsigned char> u(freq_mask_path);
     io::ibitwrap8 ms(u);
     io::ofstream<freq_t> ps(pitch_path);
 
@@ -144,41 +150,24 @@ size_t spl_calc_t::calc_pitch_bit(const char *freq_mask_path, const char *pitch_
     return calc.execute(ms, trans);
 }
 
-void spl_calc_t::calc_all_parallel(int num_samples, freq_t sample_freq, const signal_t *signal, freq_t *pitch)
+void spl_calc_t::calc_all_parallel(int num_samples, freq_t sample_freq, const signal_t *signal, freq_t *pitch) const
 {
-	io::imstream<signal_t> signal_st(signal, num_samples);
-	io::memory_buffer<spectrum_t> spec_buf = io::memory_buffer<spectrum_t>();
-	io::memory_buffer<mask_t> mask_buf = io::memory_buffer<mask_t>();
-	io::omstream<freq_t> pitch_st(pitch, num_samples * sc->size());
+    io::imstream<signal_t> signal_st(signal, num_samples);
+    io::memory_buffer<spectrum_t> spec_buf;
+    io::memory_buffer<mask_word_t> mask_buf;
+    io::omstream<freq_t> pitch_st(pitch, num_samples);
 
-	std::thread spec_thread(&spl_calc_t::spec_thread_func, this, std::ref(signal_st), std::ref(spec_buf), sample_freq);
-	std::thread mask_thread(&spl_calc_t::mask_thread_func, this, std::ref(spec_buf), std::ref(mask_buf));
-	std::thread pitch_thread(&spl_calc_t::pitch_thread_func, this, std::ref(mask_buf), std::ref(pitch_st));
-	
-	spec_thread.join();
-	mask_thread.join();
-	pitch_thread.join();
-}
-
-void spl_calc_t::spec_thread_func(io::istream<signal_t>& signal, io::memory_buffer<spectrum_t>& spec, freq_t sample_freq)
-{
-	spl::spectrum_calculator calc(*sc, sample_freq, p.spectrum.ksi);
-	calc.execute(signal, spec);
+    spl::spectrum_calculator spec_calc(*sc, sample_freq, p.spectrum.ksi);
+    spl::freq_mask_calculator_fast mask_calc(*sc, p.freq_mask);
+    spl::pitch_calculator pitch_calc(*sc, p.freq_mask, p.pitch);
+    spl::freq_translator trans(pitch_st, sc->frequences());
 
-}
-
-void spl_calc_t::mask_thread_func(io::memory_buffer<spectrum_t>& spec, io::memory_buffer<mask_t>& freq_mask)
-{
-	spl::freq_mask_calculator_fast calc(*sc, p.freq_mask);
-	calc.execute(spec, freq_mask);
-}
-
-void spl_calc_t::pitch_thread_func(io::memory_buffer<mask_t>& freq_mask, io::ostream<freq_t>& pitch)
-{
-	spl::pitch_calculator calc(*sc, p.freq_mask, p.pitch);
-	spl::freq_translator trans(pitch, sc->frequences());
-	calc.execute(freq_mask, trans);
+    io::pipeline pipe;
+    pipe.run(spec_calc, signal_st, spec_buf.output());
+    pipe.run(mask_calc, spec_buf.input(), mask_buf.output());
+    pipe.run(pitch_calc, mask_buf.input(), trans);
+    pipe.wait();
 }
 
 
-NAMESPACE_SPL_END;
\ No newline at end of file
+NAMESPACE_SPL_END;
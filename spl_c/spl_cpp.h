@@ -35,7 +35,8 @@ public:
     size_t calc_pitch_bin(const char *freq_mask_path, const char *pitch_path) const;
     size_t calc_pitch_bit(const char *freq_mask_path, const char *pitch_path) const;
 
-	void calc_all_parallel(int num_samples, freq_t sample_freq, const signal_t *signal, freq_t *pitch);
+    /// Spectrum, mask and pitch in parallel threads (see io::pipeline); \a pitch gets num_samples values.
+    void calc_all_parallel(int num_samples, freq_t sample_freq, const signal_t *signal, freq_t *pitch) const;
 
     //
     // construction
@@ -67,10 +68,6 @@ private:
 
     spl_params_t p;
     freq_scale_t *sc;
-
-	void spl_calc_t::spec_thread_func(io::istream<signal_t>& signal, io::memory_buffer<spectrum_t>& spec, freq_t sample_freq);
-	void spl_calc_t::mask_thread_func(io::memory_buffer<spectrum_t>& spec, io::memory_buffer<mask_t>& freq_mask);
-	void spl_calc_t::pitch_thread_func(io::memory_buffer<mask_t>& freq_mask, io::ostream<freq_t>& pitch);
 };
 
 NAMESPACE_SPL_END;
@@ -2,6 +2,8 @@
 #include "spl_threads.h"
 #include "in_threads.h"
 
+#include <algorithm>
+
 void C_CALL spl_pitch_signal(
 	int K,
 	int N,
@@ -14,5 +16,29 @@ void C_CALL spl_pitch_signal(
 {
 	io::imstream<signal_t> s(signal, N);
 	io::omstream<freq_t> p(pitch, N);
-	return spl::spl_pitch_in_threads(K, sample_rate, F1, F2, s, p, window_error);
-}
\ No newline at end of file
+	spl::spl_pitch_in_threads(K, sample_rate, F1, F2, s, p, window_error);
+}
+
+void C_CALL spl_vocal_signal(
+	int K,
+	int N,
+	double sample_rate,
+	freq_t F1,
+	freq_t F2,
+	double minV,
+	double minNV,
+	signal_t* signal,
+	freq_t* pitch,
+	double window_error)
+{
+	spl::vocal_params_t vp;
+	vp.minV = minV;
+	vp.minNV = minNV;
+
+	io::imstream<signal_t> s(signal, N);
+	io::omstream<freq_t> p(pitch, N);
+	spl::spl_pitch_in_threads(K, sample_rate, F1, F2, s, p, window_error, &vp);
+
+	// the end of the signal, left undecided by segmentation, is unvoiced
+	std::fill(pitch + p.pos(), pitch + N, freq_t(0));
+}
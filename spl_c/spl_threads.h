@@ -1,27 +1,10 @@
 #ifndef _SPL_THREADS_API_
 #define _SPL_THREADS_API_
 
-typedef double signal_t;
-typedef double freq_t;
-typedef double spectrum_t;
-typedef bool mask_t;
-
-#ifdef _MSC_VER
-#   define EXPORT __declspec(dllexport)
-#   define C_CALL 
-#else
-#   define EXPORT
-#   define C_CALL
-#endif
-
-#ifdef __cplusplus
-#   define EXTERN extern "C"
-#else
-#   define EXTERN
-#endif
-
-#define SPL_C_API EXTERN EXPORT
+#include "spl_c.h"
 
+/* Pitch of the signal (one value per sample, 0 - unvoiced), spectrum, mask and pitch are
+   calculated in parallel threads. F1, F2 - pitch range. */
 SPL_C_API void C_CALL spl_pitch_signal(
 	int K,
 	int N,
@@ -32,4 +15,18 @@ SPL_C_API void C_CALL spl_pitch_signal(
 	freq_t* pitch,
 	double window_error);
 
-#endif//_SPL_THREADS_API_
\ No newline at end of file
+/* The same, and the pitch is zeroed outside of voiced segments:
+   minV, minNV - minimal duration (in seconds) of voiced and unvoiced segments. */
+SPL_C_API void C_CALL spl_vocal_signal(
+	int K,
+	int N,
+	double sample_rate,
+	freq_t F1,
+	freq_t F2,
+	double minV,
+	double minNV,
+	signal_t* signal,
+	freq_t* pitch,
+	double window_error);
+
+#endif//_SPL_THREADS_API_
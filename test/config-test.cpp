@@ -28,6 +28,8 @@ class test_config_rw_c : public test_t
         params1.freq_mask.rho = 0.2;
         params1.freq_mask.delta = 1.0;
         params1.freq_mask.border_effect = false;
+        params1.temp_mask.tau = 0.05;
+        params1.temp_mask.rho = 0.2;
         params1.pitch.Nh = 3;
         params1.pitch.F1 = 50;
         params1.pitch.F2 = 400;
@@ -4,8 +4,11 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "../core/spl_types.h"
 #include "../core/conv.h"
+#include "../core/simd.h"
 #include "../core/model.h"
 #include "conv.h"
 
@@ -118,7 +121,7 @@ class test_cconv_t : public test_t
 {
 protected:
 
-    virtual double max_error() { return 1E-10; }
+    virtual double max_error() { return sizeof(real_t) < sizeof(double) ? 1E-3 : 1E-10; }
 
     template<typename T>
     void generate_test_window(T *window_re, T *window_im, freq_t freq) {
@@ -149,12 +152,13 @@ protected:
         }
     }
 
+    template<typename T>
     void generate_testdata(
-        double *signal,
-        double *window_re,
-        double *window_im,
-        double *cconv_re_naive,
-        double *cconv_im_naive,
+        T *signal,
+        T *window_re,
+        T *window_im,
+        T *cconv_re_naive,
+        T *cconv_im_naive,
         double window_freq)
     {
         typedef long double extended;
@@ -320,8 +324,8 @@ public:
     void test() {
 
         // generate test data
-        auto_ptr<double> memory(new double[11 * CCONV_TEST_SIZE]);
-        double
+        auto_ptr<real_t> memory(new real_t[13 * CCONV_TEST_SIZE]);
+        real_t
             *signal = memory.get(),
             *window_re = memory.get() + CCONV_TEST_SIZE,
             *window_im = memory.get() + 2 * CCONV_TEST_SIZE,
@@ -331,15 +335,16 @@ public:
             *signal_fft_re = signal_fft,
             *signal_fft_im = signal_fft + CCONV_TEST_SIZE,
             *window_fft_re = memory.get() + 7 * CCONV_TEST_SIZE,
-            *window_fft_im = memory.get() + 8 * CCONV_TEST_SIZE,
-            *cconv_re = memory.get() + 9 * CCONV_TEST_SIZE,
-            *cconv_im = memory.get() + 10 * CCONV_TEST_SIZE;
+            *window_fft_im = memory.get() + 9 * CCONV_TEST_SIZE,
+            *cconv_re = memory.get() + 11 * CCONV_TEST_SIZE,
+            *cconv_im = memory.get() + 12 * CCONV_TEST_SIZE;
         freq_t window_freq[] = CCONV_TEST_WINDOW_FREQ;
         int n_freq = sizeof(window_freq) / sizeof(freq_t);
 
         //	assert(CCONV_TEST_SIZE == CONV_WIN_SIZ);
 
         // real calculations start
+        cconv_workspace ws;
         unsigned long time = 0;
         for (int i = 0; i < CCONV_TEST_REPEAT; i++) {
             for (int j = 0; j < n_freq; j++) {
@@ -352,7 +357,7 @@ public:
                 cconv_calc_A(signal, signal_fft_re, signal_fft_im);
                 cconv_calc_BC(window_re, window_im, window_fft_re, window_fft_im);
                 cconv_normalize(signal_fft, 2 * CONV_WIN_SIZ);
-                cconv(signal_fft_re, signal_fft_im, window_fft_re, window_fft_im, cconv_re, cconv_im);
+                cconv(signal_fft_re, signal_fft_im, window_fft_re, window_fft_im, cconv_re, cconv_im, ws);
                 time += toc();
 
                 // calculate errors
@@ -375,23 +380,25 @@ public:
 class test_fft_approx_t : public test_error_t {
 public:
     const char *name() { return "fft_approx"; }
-    double max_error() { return 1E-10; }
+    double max_error() { return sizeof(real_t) < sizeof(double) ? 1E-1 : 1E-10; }
     double error() {
 
-        double array[CONV_WIN_SIZ * 11 + 2];
-        double *a = SPL_MEMORY_ALIGN(array);
-        double *b = a + CONV_WIN_SIZ;
-        double *c = b + CONV_WIN_SIZ;
-        double *Ar = c + CONV_WIN_SIZ;
-        double *Ai = Ar + CONV_WIN_SIZ;
-        double *B = Ai + CONV_WIN_SIZ;
-        double *C = B + CONV_WIN_SIZ;
-        double *ab1 = C + CONV_WIN_SIZ;
-        double *ac1 = ab1 + CONV_WIN_SIZ;
-        double *ab2 = ac1 + CONV_WIN_SIZ;
-        double *ac2 = ab2 + CONV_WIN_SIZ;
-
-        std::fill(ab1, ab1 + 4 * CONV_WIN_SIZ, 0.0);
+        // буферы размером в real_t для окна N (conv_alloc выравнивает начало)
+        const int N = CONV_WIN_SIZ, step = conv_spec_step(N);
+        real_t *array = conv_alloc<real_t>(7 * N + 6 * step);
+        real_t *a = array;
+        real_t *b = a + N;
+        real_t *c = b + N;
+        real_t *Ar = c + N;
+        real_t *Ai = Ar + step;
+        real_t *B = Ai + step;
+        real_t *C = B + 2 * step;
+        real_t *ab1 = C + 2 * step;
+        real_t *ac1 = ab1 + N;
+        real_t *ab2 = ac1 + N;
+        real_t *ac2 = ab2 + N;
+
+        std::fill(ab1, ab1 + 4 * N, real_t(0));
 
         int Ws = 12;
         freq_t Fr = 200, dF = 3; // какие тут частоты указывать - не имеет особого значения
@@ -399,16 +406,21 @@ public:
         for (int m = -Ws; m <= Ws; m++) {
             a[Ws + m] = model::gauss_win(Fr + m * dF, Fr, std);
         }
-        std::fill(a + 2 * Ws + 1, a + CONV_WIN_SIZ, 0.0);
+        std::fill(a + 2 * Ws + 1, a + N, real_t(0));
 
-        fill_test_array((fftw_complex*)B, b, c);
+        for (int i = 0; i < N; i++) {
+            double I = double(i);
+            b[i] = real_t(sin(I) * sin(2 * I));
+            c[i] = real_t(sin(I) * sin(2 * I) + 5);
+        }
 
-        cconv_calc_A(a, Ar, Ai);
-        cconv_normalize(Ar, 2 * CONV_WIN_SIZ);
-        cconv_calc_BC(b, c, B, C);
-        cconv(Ar, Ai, B, C, ab1, ac1);
+        cconv_calc_A(a, Ar, Ai, N);
+        cconv_normalize(Ar, 2 * step, N);
+        cconv_calc_BC(b, c, B, C, N);
+        cconv_workspace ws(N);
+        cconv(Ar, Ai, B, C, ab1, ac1, ws);
 
-        for (int i = Ws; i < CONV_WIN_SIZ - Ws; i++) {
+        for (int i = Ws; i < N - Ws; i++) {
             double sumb = 0.0, sumc = 0.0;
             for (int m = -Ws; m <= Ws; m++) {
                 sumb += a[Ws + m] * b[i - m];
@@ -418,20 +430,289 @@ public:
             ac2[i] = sumc;
         }
 
-        io::array_to_file(ab1, CONV_WIN_SIZ, "cconv-1-fft.bin");
-        io::array_to_file(ac1, CONV_WIN_SIZ, "cconv-2-fft.bin");
-        io::array_to_file(ab2, CONV_WIN_SIZ, "cconv-1-naive.bin");
-        io::array_to_file(ac2, CONV_WIN_SIZ, "cconv-2-naive.bin");
+        io::array_to_file(ab1, N, "cconv-1-fft.bin");
+        io::array_to_file(ac1, N, "cconv-2-fft.bin");
+        io::array_to_file(ab2, N, "cconv-1-naive.bin");
+        io::array_to_file(ac2, N, "cconv-2-naive.bin");
 
         double e1 = 0.0, e2 = 0.0;
-        for (int i = Ws; i < CONV_WIN_SIZ - Ws; i++) {
+        // ab1 сдвинут на Ws относительно ab2: последний индекс (N - Ws - 1) + Ws < N
+        for (int i = Ws; i < N - Ws; i++) {
             e1 += fabs(ab1[i + Ws] - ab2[i]);
             e2 += fabs(ac1[i + Ws] - ac2[i]);
         }
 
+        conv_free(array);
         return e1;
     }
 } test_fft_approx;
 
+class test_cconv_batch_t : public test_cconv_t {
+public:
+    const char *name() { return "cconv_batch"; }
+    void test() {
+        freq_t window_freq[] = CCONV_TEST_WINDOW_FREQ;
+        const int K = sizeof(window_freq) / sizeof(freq_t);
+
+        // generate test data: one signal, K windows
+        auto_ptr<real_t> memory(new real_t[(7 + 2 * K) * CCONV_TEST_SIZE + 4 * K * CONV_SPEC_STEP]);
+        real_t
+            *signal = memory.get(),
+            *window_re = signal + CCONV_TEST_SIZE,
+            *window_im = window_re + CCONV_TEST_SIZE,
+            *signal_fft_re = window_im + CCONV_TEST_SIZE,
+            *signal_fft_im = signal_fft_re + CCONV_TEST_SIZE,
+            *cconv_re = signal_fft_im + CCONV_TEST_SIZE,
+            *cconv_im = cconv_re + CCONV_TEST_SIZE,
+            *B = cconv_im + CCONV_TEST_SIZE,
+            *C = B + K * (2 * CONV_SPEC_STEP),
+            *cconv_re_naive = C + K * (2 * CONV_SPEC_STEP),
+            *cconv_im_naive = cconv_re_naive + K * CCONV_TEST_SIZE;
+
+        for (int k = 0; k < K; k++) {
+            generate_testdata(signal, window_re, window_im, 
+                cconv_re_naive + k * CCONV_TEST_SIZE, cconv_im_naive + k * CCONV_TEST_SIZE, window_freq[k]);
+            cconv_calc_BC(window_re, window_im, B + k * (2 * CONV_SPEC_STEP), C + k * (2 * CONV_SPEC_STEP));
+        }
+        cconv_normalize(B, 2 * K * (2 * CONV_SPEC_STEP));
+        cconv_calc_A(signal, signal_fft_re, signal_fft_im);
+
+        // compute all channels at once
+        cconv_batch conv(K);
+        tic();
+        conv.execute(signal_fft_re, signal_fft_im, B, C);
+        set_execution_time(toc());
+
+        for (int k = 0; k < K; k++) {
+            std::copy(conv.ab(k), conv.ab(k) + CCONV_TEST_SIZE, cconv_re);
+            std::copy(conv.ac(k), conv.ac(k) + CCONV_TEST_SIZE, cconv_im);
+            cconv_calc_error(cconv_re, cconv_im, 
+                cconv_re_naive + k * CCONV_TEST_SIZE, cconv_im_naive + k * CCONV_TEST_SIZE);
+        }
+    }
+} test_cconv_batch;
+
+
+class test_cconv_workspace_t : public test_t {
+public:
+    const char *name() { return "cconv_workspace"; }
+    void test() {
+        real_t *array = conv_alloc<real_t>(CONV_WIN_SIZ * 3 + CONV_SPEC_STEP * 6);
+        real_t *a = array;
+        real_t *Ar = a + CONV_WIN_SIZ;
+        real_t *Ai = Ar + CONV_SPEC_STEP;
+        real_t *B = Ai + CONV_SPEC_STEP;
+        real_t *C = B + 2 * CONV_SPEC_STEP;
+        real_t *ab = C + 2 * CONV_SPEC_STEP;
+        real_t *ac = ab + CONV_WIN_SIZ;
+
+        for (int i = 0; i < CONV_WIN_SIZ; i++) {
+            a[i] = sin(0.1 * i);
+            ab[i] = cos(0.2 * i);
+            ac[i] = sin(0.3 * i);
+        }
+        cconv_calc_A(a, Ar, Ai);
+        cconv_calc_BC(ab, ac, B, C);
+
+        cconv_workspace ws;
+        const size_t count = conv_alloc_count();
+        for (int i = 0; i < 100; i++) {
+            cconv(Ar, Ai, B, C, ab, ac, ws);
+        }
+        assert(conv_alloc_count() == count, "cconv allocated memory: %d times", int(conv_alloc_count() - count));
+
+        conv_free(array);
+    }
+} test_cconv_workspace;
+
+
+class test_cconv_choose_size_t : public test_t {
+public:
+    const char *name() { return "cconv_choose_size"; }
+    void test() {
+        const int Ws[] = { 10, 100, 500, 3000, CONV_MAX_SIZ };
+        const size_t lengths[] = { 0, 100, 1000, 10000, 100000, 10000000 };
+        const int Ks[] = { 1, 16, 128 };
+
+        for (int w: Ws) for (int K: Ks) {
+            int min_N = CONV_MIN_SIZ;
+            while (min_N < 2 * w) min_N *= 2;
+            for (size_t L: lengths) {
+                if (L == 0) continue;
+                const int N = cconv_choose_size(w, L, K);
+                assert((N & (N - 1)) == 0, "Ws %d, K %d, length %d: size %d is not a power of 2", w, K, int(L), N);
+                assert(N >= min_N && N <= std::max(min_N, CONV_MAX_SIZ),
+                    "Ws %d, K %d, length %d: size %d out of [%d, %d]", w, K, int(L), N, min_N, std::max(min_N, CONV_MAX_SIZ));
+                // блок больше, чем нужно для всего сигнала за один раз, только дороже
+                int one_block = min_N;
+                while (one_block - w + 1 < (int)std::min<size_t>(L, CONV_MAX_SIZ)) one_block *= 2;
+                assert(N <= one_block, "Ws %d, K %d, length %d: size %d is more than one block %d", w, K, int(L), N, one_block);
+            }
+            // длина неизвестна - как для очень длинного сигнала
+            const int N = cconv_choose_size(w, 0, K);
+            assert(N == cconv_choose_size(w, lengths[5], K), "Ws %d, K %d: size %d for unknown length", w, K, N);
+        }
+
+        // сигнал помещается в наименьший блок
+        assert(cconv_choose_size(100, 100) == CONV_MIN_SIZ, "short signal: size %d", cconv_choose_size(100, 100));
+        // длинный сигнал: блок в несколько окон фильтра, FFT на отсчет близко к минимуму
+        for (int K: Ks) {
+            const int N = cconv_choose_size(500, 0, K);
+            assert(N >= 4 * 500 && N <= 16 * 500, "long signal, Ws 500, K %d: size %d", K, N);
+        }
+    }
+} test_cconv_choose_size;
+
+
+class test_cconv_threads_t : public test_t {
+public:
+    const char *name() { return "cconv_threads"; }
+    void test() {
+        // планы создаются лениво из нескольких потоков одновременно
+        conv_set_plan_mode(conv_plan_estimate);
+
+        const int T = 4;
+        real_t *array = conv_alloc<real_t>(T * CONV_WIN_SIZ);
+        real_t *a = conv_alloc<real_t>(CONV_WIN_SIZ);
+        for (int i = 0; i < CONV_WIN_SIZ; i++) {
+            a[i] = sin(0.1 * i) + cos(0.01 * i * i);
+        }
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < T; t++) {
+            threads.push_back(std::thread([=]() {
+                real_t *A = conv_alloc<real_t>(2 * CONV_SPEC_STEP);
+                for (int j = 0; j < 10; j++) {
+                    cconv_calc_A(a, A, A + CONV_SPEC_STEP);
+                    cconv_batch conv(t + 1);
+                }
+                std::copy(A, A + CONV_SPEC_SIZ, array + t * CONV_WIN_SIZ);
+                conv_free(A);
+            }));
+        }
+        for (auto& t: threads) t.join();
+
+        real_t *A = conv_alloc<real_t>(2 * CONV_SPEC_STEP);
+        cconv_calc_A(a, A, A + CONV_SPEC_STEP);
+        for (int t = 0; t < T; t++) {
+            assert(std::equal(A, A + CONV_SPEC_SIZ, array + t * CONV_WIN_SIZ), 
+                "thread %d: FFT result differs", t);
+        }
+        conv_set_plan_mode(conv_plan_measure);
+
+        conv_free(A);
+        conv_free(a);
+        conv_free(array);
+    }
+} test_cconv_threads;
+
+
+///
+/// Векторные ядра свертки: сравнение каждого уровня SIMD со скалярным вариантом.
+/// Печатает время умножения (AB,AC) = A .* (B,C) и вычисления |x|^2 на половине спектра.
+///
+class test_conv_kernels_t : public test_t {
+public:
+    const char *name() { return "conv_kernels"; }
+    void test() {
+        const size_t N = CONV_SPEC_SIZ, step = CONV_SPEC_STEP;
+        const int R = 20000;
+        real_t *array = conv_alloc<real_t>(2 * step + 4 * 2 * step + 2 * N);
+        real_t *Ar = array, *Ai = Ar + step;
+        real_t *B = Ai + step, *C = B + 2 * step;
+        real_t *AB = C + 2 * step, *AC = AB + 2 * step;
+        real_t *ref = AC + 2 * step, *out = ref + N;
+        for (size_t i = 0; i < 2 * step; i++) {
+            array[i] = sin(0.1 * i);
+            B[i] = cos(0.2 * i);
+            C[i] = sin(0.3 * i) + 0.5;
+        }
+        std::vector<real_t> ref_AB(2 * step), ref_AC(2 * step);
+        real_t *inplace = conv_alloc<real_t>(2 * step);
+
+        const simd_level_t supported = simd_supported();
+        for (int level = simd_scalar; level <= supported; level++) {
+            simd_set_level(simd_level_t(level));
+
+            tic();
+            for (int r = 0; r < R; r++)
+                complex_mul_split2(N, Ar, Ai, B, C, AB, AC, step);
+            const time_t t_mul = toc();
+
+            tic();
+            for (int r = 0; r < R; r++)
+                complex_abs_split(N, AB, AB + step, out);
+            const time_t t_abs = toc();
+
+            printf("%s: mul %d ms, abs %d ms\n", simd_level_name(simd_level_t(level)), int(t_mul), int(t_abs));
+
+            if (level == simd_scalar) {
+                std::copy(AB, AB + 2 * step, ref_AB.begin());
+                std::copy(AC, AC + 2 * step, ref_AC.begin());
+                std::copy(out, out + N, ref);
+                continue;
+            }
+            // FMA округляет иначе, чем скалярный вариант
+            const double eps = 1E-5;
+            double e = 0;
+            for (size_t i = 0; i < N; i++) {
+                e = std::max(e, (double)fabs(AB[i] - ref_AB[i]) + fabs(AB[step + i] - ref_AB[step + i]));
+                e = std::max(e, (double)fabs(AC[i] - ref_AC[i]) + fabs(AC[step + i] - ref_AC[step + i]));
+                e = std::max(e, (double)fabs(out[i] - ref[i]) / (1 + ref[i]));
+            }
+            assert(e < eps, "%s kernels differ from scalar: %lg", simd_level_name(simd_level_t(level)), e);
+        }
+        simd_set_level(supported);
+
+        // in-place: результат AB пишется поверх A
+        for (int level = simd_scalar; level <= supported; level++) {
+            simd_set_level(simd_level_t(level));
+            std::copy(Ar, Ar + 2 * step, inplace);
+            complex_mul_split2(N, inplace, inplace + step, B, C, inplace, AC, step);
+            double e = 0;
+            for (size_t i = 0; i < N; i++) {
+                e = std::max(e, (double)fabs(inplace[i] - ref_AB[i]) + fabs(inplace[step + i] - ref_AB[step + i]));
+                e = std::max(e, (double)fabs(AC[i] - ref_AC[i]) + fabs(AC[step + i] - ref_AC[step + i]));
+            }
+            assert(e < 1E-5, "%s: in-place product differs: %lg", simd_level_name(simd_level_t(level)), e);
+        }
+        simd_set_level(supported);
+
+        conv_free(inplace);
+        conv_free(array);
+    }
+} test_conv_kernels;
+
+
+class test_conv_abs_transposed_t : public test_t {
+public:
+    const char *name() { return "conv_abs_transposed"; }
+    void test() {
+        // размеры не кратны ширине векторов и блоку - проверяются и хвосты
+        const size_t K = 13, N = 77, stride = 101;
+        std::vector<real_t> Ar(K * stride), Ai(K * stride), Am(N * K);
+        for (size_t i = 0; i < K * stride; i++) {
+            Ar[i] = real_t(sin(0.1 * i));
+            Ai[i] = real_t(cos(0.7 * i));
+        }
+
+        const simd_level_t supported = simd_supported();
+        for (int level = simd_scalar; level <= supported; level++) {
+            simd_set_level(simd_level_t(level));
+            std::fill(Am.begin(), Am.end(), real_t(-1));
+            complex_abs_split_transposed(K, N, &Ar[0], &Ai[0], stride, &Am[0]);
+            for (size_t k = 0; k < K; k++) {
+                for (size_t j = 0; j < N; j++) {
+                    const real_t *ar = &Ar[k * stride], *ai = &Ai[k * stride];
+                    const double e = fabs(Am[j * K + k] - (ar[j] * ar[j] + ai[j] * ai[j]));
+                    assert(e < 1E-6, "%s: wrong value at (%d, %d)", 
+                        simd_level_name(simd_level_t(level)), int(j), int(k));
+                }
+            }
+        }
+        simd_set_level(supported);
+    }
+} test_conv_abs_transposed;
+
 
 NAMESPACE_TEST_END;
\ No newline at end of file
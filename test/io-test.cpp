@@ -1,11 +1,17 @@
 #include "test.h"
 #include "../io/iomem.h"
 #include "../io/iofile.h"
+#include "../io/ioasync.h"
+#include "../io/iommap.h"
 #include "../io/iobit.h"
 #include "../io/iobuf.h"
+#include "../io/iopipe.h"
 #include "../io/iowave.h"
 #include <stdio.h>
 #include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
 
 NAMESPACE_TEST_BEGIN;
 
@@ -15,6 +21,10 @@ const char *signal_std = "E:/testdata/signal.bin";
 const char *signal_wav_std = "E:/testdata/signal.wav";
 const char *numbers_std = "E:/testdata/256.bi";
 const char *numbers_test = "E:/testdata/test-256.bi";
+const char *mmap_test = "E:/testdata/test-mmap.bi";
+const char *mmap_wav_test = "E:/testdata/test-mmap.wav";
+const char *async_test = "E:/testdata/test-async.bi";
+const char *async_std = "E:/testdata/test-async-std.bi";
 
 // streams comparison
 
@@ -85,29 +95,25 @@ class test_iobuf_t : public test_t {
         ofstream<elem_t> output(numbers_test);
         memory_buffer<elem_t> buffer;
 
-        elem_t block[25];
-        size_t size1 = 20,
-            size2 = 15,
-            size3 = 25,
-            read, written;
-        while (!input.eos()) {
-            read = input.read(block, size1);
-
-            written = buffer.output().write(block, read);
-            assert(written == read, "written != read: %d != %d\n", written, read);
-
-            read = buffer.input().read(block, size2);
-            assert(read == size2, "should have read %d elements, but read %d elements\n", size2, read);
-
-            output.write(block, read);
-        }
-        buffer.output().close();
+        // writes are published in whole blocks, so the writer and the reader are different threads
+        const size_t size1 = 20, size2 = 15;
+        std::thread producer([&]() {
+            elem_t block[size1];
+            while (!input.eos()) {
+                size_t read = input.read(block, size1);
+                size_t written = buffer.output().write(block, read);
+                assert(written == read, "written != read: %d != %d\n", written, read);
+            }
+            buffer.output().close();
+        });
 
-        // write the remainder
-        while (!buffer.input().eos()) {
-            read = buffer.input().read(block, size3);
+        elem_t block[size2];
+        size_t read;
+        while ((read = buffer.input().read(block, size2)) > 0) {
+            assert(read == size2 || buffer.input().eos(), "should have read %d elements, but read %d elements\n", size2, read);
             output.write(block, read);
         }
+        producer.join();
 
         input.close();
         output.close();
@@ -117,4 +123,462 @@ class test_iobuf_t : public test_t {
     }
 } test_iobuf;
 
+class test_iommap_t : public test_t {
+
+    const char *name() override { return "iommap"; }
+
+    /// Writes wave-file: compression \a code, \a M channels, \a B bits per value.
+    static void write_wave(const char *path, unsigned short code, unsigned short M, unsigned short B,
+        unsigned F, const void *data, unsigned size)
+    {
+        ofstream<unsigned char> out(path);
+        const unsigned short align = M * B / 8;
+        const unsigned rate = F * align;
+        const unsigned fmt_size = 16, riff_size = 4 + 8 + fmt_size + 8 + size;
+        out.write((const unsigned char *)"RIFF", 4);
+        out.write((const unsigned char *)&riff_size, 4);
+        out.write((const unsigned char *)"WAVEfmt ", 8);
+        out.write((const unsigned char *)&fmt_size, 4);
+        out.write((const unsigned char *)&code, 2);
+        out.write((const unsigned char *)&M, 2);
+        out.write((const unsigned char *)&F, 4);
+        out.write((const unsigned char *)&rate, 4);
+        out.write((const unsigned char *)&align, 2);
+        out.write((const unsigned char *)&B, 2);
+        out.write((const unsigned char *)"data", 4);
+        out.write((const unsigned char *)&size, 4);
+        out.write((const unsigned char *)data, size);
+    }
+
+    void test() override {
+        const size_t N = 1 << 22, B = 4096;
+        std::vector<double> x(N), y(B);
+        for (size_t i = 0; i < N; i++) x[i] = sin(i * 0.001);
+        {
+            ofstream<double> out(mmap_test);
+            out.write(x.data(), N);
+        }
+
+        // the same data as ifstream, by blocks
+        immstream<double> m(mmap_test);
+        assert(m.size() == N, "wrong size: %d", int(m.size()));
+        double e;
+        {
+            ifstream<double> f(mmap_test);
+            tic();
+            while (f.read(y.data(), B) > 0);
+            time_t t1 = toc();
+            tic();
+            while (m.read(y.data(), B) > 0);
+            time_t t2 = toc();
+            printf("ifstream %5.0f M/s, immstream %5.0f M/s\n",
+                N / 1e3 / std::max<time_t>(t1, 1), N / 1e3 / std::max<time_t>(t2, 1));
+            f.pos(0);
+            m.pos(0);
+            e = compare_streams<double>(f, m);
+            assert(e == 0 && m.eos(), "immstream differs from ifstream: %f", e);
+        }
+
+        // random access and in-place input
+        assert(m.pos(N / 3) == N / 3 && m.read(y.data(), 10) == 10 && std::equal(y.data(), y.data() + 10, &x[N / 3]),
+            "immstream: wrong pos()");
+        assert(m.skip(N / 3) == 2 * (N / 3) + 10 && m.get(y[0]) && y[0] == x[2 * (N / 3) + 10],
+            "immstream: wrong skip()");
+        assert(m.skip(N) == N && m.eos() && m.pos(0) == 0, "immstream: skip() over the end");
+        size_t count = N;
+        const double *span = m.acquire_read(y.data(), count);
+        assert(span != y.data() && count == N && std::equal(span, span + N, x.data()), "immstream: not in place");
+        m.commit_read(count);
+        assert(m.eos(), "immstream: commit_read()");
+        m.close();
+
+        // 16-bit stereo wave-file: the same samples as iwstream
+        std::vector<short> pcm(2 * N);
+        for (size_t i = 0; i < 2 * N; i++) pcm[i] = short(16000 * x[i / 2] + (i % 2) * 100);
+        write_wave(mmap_wav_test, 1, 2, 16, 12000, pcm.data(), unsigned(pcm.size() * sizeof(short)));
+        {
+            iwstream<double> w(mmap_wav_test);
+            iwmstream<double> wm(mmap_wav_test);
+            assert(wm.freq() == 12000 && wm.size() == N, "iwmstream: wrong header");
+            e = compare_streams<double>(w, wm);
+            assert(e == 0 && wm.eos(), "iwmstream differs from iwstream: %f", e);
+            double z;
+            assert(wm.pos(N - 5) == N - 5 && wm.get(z) && z == (pcm[2 * N - 10] + pcm[2 * N - 9]) / 32768.0,
+                "iwmstream: wrong pos()");
+        }
+
+        // mono float wave-file: samples are returned in place
+        std::vector<float> xf(x.begin(), x.end());
+        write_wave(mmap_wav_test, 3, 1, 32, 12000, xf.data(), unsigned(N * sizeof(float)));
+        iwmstream<float> wf(mmap_wav_test);
+        std::vector<float> yf(B);
+        count = B;
+        const float *fspan = wf.acquire_read(yf.data(), count);
+        assert(fspan != yf.data() && count == B && std::equal(fspan, fspan + B, xf.data()),
+            "iwmstream: float samples not in place");
+        wf.commit_read(count);
+        assert(wf.read(yf.data(), B) == B && std::equal(yf.begin(), yf.end(), &xf[B]), "iwmstream: float samples");
+        wf.close();
+
+        remove(mmap_test);
+        remove(mmap_wav_test);
+    }
+} test_iommap;
+
+class test_aofstream_t : public test_t {
+
+    const char *name() override { return "aofstream"; }
+    void test() override {
+        const size_t N = 1 << 23, B = 1000, K = 256;
+        std::vector<double> x(N);
+        for (size_t i = 0; i < N; i++) x[i] = double(i);
+
+        // synchronous and asynchronous output by blocks
+        time_t t1, t2;
+        {
+            ofstream<double> out(async_std);
+            tic();
+            for (size_t i = 0; i < N; i += B) out.write(x.data() + i, std::min(B, N - i));
+            t1 = toc();
+        }
+        {
+            aofstream<double> out(async_test, 1 << 16);
+            tic();
+            size_t w = 0;
+            for (size_t i = 0; i < N; i += B) w += out.write(x.data() + i, std::min(B, N - i));
+            t2 = toc();
+            out.close();
+            assert(w == N && out.pos() == N && out.eos() && !out.failed(), "aofstream: written %d of %d", int(w), int(N));
+        }
+        printf("ofstream %5.0f M/s, aofstream %5.0f M/s (without close)\n",
+            N / 1e3 / std::max<time_t>(t1, 1), N / 1e3 / std::max<time_t>(t2, 1));
+        double e = compare_streams<double>(async_std, async_test);
+        assert(e == 0, "aofstream::write: non-zero error %f", e);
+
+        // rows of K elements in place: a row is not split between blocks (block is not a multiple of a row)
+        {
+            aofstream<double> out(async_test, 3000 * sizeof(double), 3);
+            std::vector<double> buf(B * K);
+            size_t i = 0;
+            while (i < N) {
+                size_t count = std::min(B * K, (N - i) / K * K);
+                if (count == 0) break;
+                double *span = out.acquire_write(buf.data(), count, K);
+                assert(count % K == 0 && count > 0, "aofstream: span of %d elements", int(count));
+                std::copy(x.data() + i, x.data() + i + count, span);
+                i += out.commit_write(span, count);
+            }
+            i += out.write(x.data() + i, N - i);
+            assert(i == N, "aofstream: written %d of %d", int(i), int(N));
+        }
+        e = compare_streams<double>(async_std, async_test);
+        assert(e == 0, "aofstream::acquire_write: non-zero error %f", e);
+
+        remove(async_test);
+        remove(async_std);
+    }
+} test_aofstream;
+
+class test_pipeline_t : public test_t {
+
+    typedef int elem_t;
+
+    /// Adds 1 to every element; throws after \a fail_at elements.
+    class inc_filter : public filter<elem_t> {
+    public:
+        inc_filter(size_t fail_at_ = 0) : fail_at(fail_at_) {}
+        size_t execute(istream<elem_t>& input, ostream<elem_t>& output) const override {
+            elem_t block[100];
+            size_t read, total = 0;
+            while ((read = input.read(block, 37)) > 0) {
+                for (size_t i = 0; i < read; i++) block[i]++;
+                output.write(block, read);
+                total += read;
+                if (fail_at && total >= fail_at) throw "inc_filter: failure";
+            }
+            return total;
+        }
+        size_t fail_at;
+    };
+
+    const char *name() override { return "pipeline"; }
+    void test() override {
+        const size_t N = 100000;
+        std::vector<elem_t> x(N), y(N + 1, -1);
+        for (size_t i = 0; i < N; i++) x[i] = elem_t(i);
+
+        // small buffers: stages wait for each other many times
+        // (the first one spins before parking, the second one parks at once)
+        imstream<elem_t> input(x.data(), N);
+        omstream<elem_t> output(y.data(), N + 1);
+        memory_buffer<elem_t> buf1(64, 2), buf2(40, 3, 0);
+        inc_filter f;
+        {
+            pipeline pipe;
+            tic();
+            pipe.run(f, input, buf1.output());
+            pipe.run(f, buf1.input(), buf2.output());
+            pipe.run(f, buf2.input(), output);
+            pipe.wait();
+            toc();
+        }
+        size_t errors = 0;
+        for (size_t i = 0; i < N; i++) errors += y[i] != x[i] + 3;
+        assert(errors == 0 && y[N] == -1, "wrong output: %d errors", int(errors));
+
+        // stages close their streams, so the second run gets new ones
+        assert(input.eos() && output.eos(), "stage streams are not closed");
+
+        // failure of the middle stage stops the whole pipeline and is rethrown by wait()
+        imstream<elem_t> input2(x.data(), N);
+        omstream<elem_t> output2(y.data(), N + 1);
+        memory_buffer<elem_t> buf3(64, 2), buf4(64, 2);
+        inc_filter g(1000);
+        const char *error = 0;
+        pipeline pipe;
+        pipe.run(f, input2, buf3.output());
+        pipe.run(g, buf3.input(), buf4.output());
+        pipe.run(f, buf4.input(), output2);
+        try {
+            pipe.wait();
+        }
+        catch (const char *e) {
+            error = e;
+        }
+        assert(error != 0, "stage exception was not rethrown");
+    }
+} test_pipeline;
+
+class test_iobuf_span_t : public test_t {
+
+    typedef double elem_t;
+
+    const char *name() override { return "iobuf_span"; }
+
+    /// Frames of \a K elements through a buffer of \a block_size bytes: written and read by spans.
+    /// Returns number of bytes copied by the buffer.
+    size_t transfer(size_t K, size_t frames, size_t block_size) {
+        std::vector<elem_t> buf(16 * K), y;
+        memory_buffer<elem_t> buffer(block_size, 4);
+
+        std::thread producer([&]() {
+            ostream<elem_t>& out = buffer.output();
+            for (size_t f = 0; f < frames; ) {
+                size_t n = std::min<size_t>(16, frames - f) * K;
+                elem_t *span = out.acquire_write(buf.data(), n, K);
+                for (size_t i = 0; i < n; i++) span[i] = elem_t(f * K + i);
+                out.commit_write(span, n);
+                f += n / K;
+            }
+            out.close();
+        });
+
+        std::vector<elem_t> frame(16 * K);
+        istream<elem_t>& in = buffer.input();
+        for (;;) {
+            size_t n = frame.size();
+            const elem_t *span = in.acquire_read(frame.data(), n, K);
+            assert(n % K == 0, "span of %d elements is not a whole number of frames", int(n));
+            y.insert(y.end(), span, span + n);
+            in.commit_read(n);
+            if (n == 0) break;
+        }
+        producer.join();
+
+        size_t errors = y.size() != frames * K;
+        for (size_t i = 0; !errors && i < y.size(); i++) errors += y[i] != elem_t(i);
+        assert(errors == 0, "wrong output: %d of %d elements", int(y.size()), int(frames * K));
+        return buffer.bytes_copied();
+    }
+
+    void test() override {
+        // spans of whole frames are passed without copying
+        size_t copied = transfer(256, 1000, 1 << 16);
+        assert(copied == 0, "%d bytes copied", int(copied));
+
+        // the block is smaller than a frame - spans fall back to read() and write()
+        copied = transfer(256, 1000, 1000);
+        assert(copied == 2 * 1000 * 256 * sizeof(elem_t), "%d bytes copied", int(copied));
+
+        // memory streams give their memory as spans
+        elem_t x[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }, z[10];
+        imstream<elem_t> input(x, 10);
+        omstream<elem_t> output(z, 10);
+        size_t n = 4;
+        const elem_t *in_span = input.acquire_read(z, n, 2);
+        elem_t *out_span = output.acquire_write(x, n, 2);
+        assert(in_span == x && out_span == z && n == 4, "memory stream spans are not in place");
+        std::copy(in_span, in_span + n, out_span);
+        input.commit_read(n);
+        output.commit_write(out_span, n);
+        assert(input.pos() == 4 && output.pos() == 4 && z[3] == 3, "memory stream spans are not committed");
+    }
+} test_iobuf_span;
+
+class test_iobuf_throughput_t : public test_t {
+
+    const char *name() override { return "iobuf_throughput"; }
+
+    /// Producer and consumer threads pass \a N doubles through a default memory_buffer
+    ///  by writes and reads of \a C elements. Returns time in ms.
+    time_t transfer(size_t N, size_t C) {
+        std::vector<double> x(C), y(C);
+        for (size_t i = 0; i < C; i++) x[i] = double(i);
+        memory_buffer<double> buffer;
+
+        tic();
+        std::thread producer([&]() {
+            ostream<double>& out = buffer.output();
+            for (size_t n = 0; n < N; n += C) out.write(x.data(), C);
+            out.close();
+        });
+        istream<double>& in = buffer.input();
+        size_t total = 0, errors = 0, read;
+        while ((read = in.read(y.data(), C)) > 0) {
+            errors += read != C || y[C - 1] != x[C - 1];
+            total += read;
+        }
+        producer.join();
+        time_t t = toc();
+
+        assert(errors == 0 && total == N, "wrong output: %d of %d elements, %d errors", int(total), int(N), int(errors));
+        return t;
+    }
+
+    void test() override {
+        const size_t N = 1 << 23;
+        const size_t chunks[] = { 8, 256, 2048 };
+        for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+            time_t t = transfer(N, chunks[i]);
+            printf("memory_buffer %5d-byte writes %6.0f MB/s\n", int(chunks[i] * sizeof(double)),
+                N * sizeof(double) / 1e3 / std::max<time_t>(t, 1));
+        }
+    }
+} test_iobuf_throughput;
+
+class test_io_bulk_t : public test_t {
+
+    const char *name() override { return "io_bulk"; }
+
+    /// Reads \a in by elements (get) and by blocks (read): results should be equal.
+    /// \a rewind resets the stream. Prints throughput of both.
+    template<typename T, typename R>
+    void compare_read(const char *title, istream<T>& in, const T *ref, size_t count, R rewind) {
+        const size_t B = 1000;
+        std::unique_ptr<T[]> x(new T[count]), y(new T[count]);
+        rewind();
+        tic();
+        size_t n1 = in.template read<T>(x.get(), count);
+        time_t t1 = toc();
+        rewind();
+        tic();
+        size_t n2 = 0, r;
+        while (n2 < count && (r = in.read(y.get() + n2, std::min(B, count - n2))) > 0) n2 += r;
+        time_t t2 = toc();
+        assert(n1 == count && n2 == count && std::equal(ref, ref + count, x.get()) && std::equal(ref, ref + count, y.get()),
+            "%s: wrong input (%d, %d of %d)", title, int(n1), int(n2), int(count));
+        printf("%-10s read:  by element %5.0f M/s, by block %5.0f M/s\n", title,
+            count / 1e3 / std::max<time_t>(t1, 1), count / 1e3 / std::max<time_t>(t2, 1));
+    }
+
+    /// Writes \a x to \a out by elements (put) and by blocks (write): \a result should equal \a ref.
+    template<typename T, typename R, typename U>
+    void compare_write(const char *title, ostream<T>& out, const T *x, size_t count, R rewind, 
+        const U *result, const U *ref, size_t result_count)
+    {
+        const size_t B = 1000;
+        rewind();
+        tic();
+        size_t n1 = out.template write<T>(x, count);
+        time_t t1 = toc();
+        bool ok1 = std::equal(ref, ref + result_count, result);
+        rewind();
+        tic();
+        size_t n2 = 0;
+        for (size_t i = 0; i < count; i += B) n2 += out.write(x + i, std::min(B, count - i));
+        time_t t2 = toc();
+        bool ok2 = std::equal(ref, ref + result_count, result);
+        assert(n1 == count && n2 == count && ok1 && ok2, "%s: wrong output (%d, %d of %d)",
+            title, int(n1), int(n2), int(count));
+        printf("%-10s write: by element %5.0f M/s, by block %5.0f M/s\n", title,
+            count / 1e3 / std::max<time_t>(t1, 1), count / 1e3 / std::max<time_t>(t2, 1));
+    }
+
+    void test() override {
+        const size_t N = 1 << 24;
+        unsigned r = 1;
+        std::vector<short> shorts(N);
+        for (size_t i = 0; i < N; i++) shorts[i] = short((r = r * 1103515245u + 12345u) >> 16);
+        std::vector<double> doubles(shorts.begin(), shorts.end());
+        std::vector<uint64_t> words(N / 64);
+        for (size_t i = 0; i < words.size(); i++) words[i] = (uint64_t(rand()) << 40) ^ (uint64_t(rand()) << 20) ^ rand();
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(words.data());
+        std::unique_ptr<bool[]> bits(new bool[N]);
+        for (size_t i = 0; i < N; i++) bits[i] = (bytes[i / 8] >> (i % 8)) & 1;
+
+        // memory streams
+        imstream<short> ims(shorts.data(), N);
+        compare_read("imstream", ims, shorts.data(), N, [&]() { ims.pos(0); });
+        std::vector<short> out_shorts(N);
+        omstream<short> oms(out_shorts.data(), N);
+        compare_write("omstream", oms, shorts.data(), N, [&]() { oms.pos(0); }, out_shorts.data(), shorts.data(), N);
+
+        // element conversion
+        iwrapelem<double, short> iconv(ims);
+        compare_read("iwrapelem", iconv, doubles.data(), N, [&]() { ims.pos(0); });
+        std::vector<double> out_doubles(N);
+        omstream<double> omd(out_doubles.data(), N);
+        owrapelem<short, double> oconv(omd);
+        compare_write("owrapelem", oconv, shorts.data(), N, [&]() { omd.pos(0); }, out_doubles.data(), doubles.data(), N);
+
+        // bit streams: 8 and 64 bits per word
+        imstream<uint8_t> ib8(bytes, N / 8);
+        ibitwrap8 ibits8(ib8);
+        compare_read("ibitwrap8", ibits8, bits.get(), N, [&]() { ibits8.pos(0); });
+        imstream<uint64_t> ib64(words.data(), N / 64);
+        ibitwrap64 ibits64(ib64);
+        compare_read("ibitwrap64", ibits64, bits.get(), N, [&]() { ibits64.pos(0); });
+
+        std::vector<uint8_t> out_bytes(N / 8);
+        omstream<uint8_t> ob8(out_bytes.data(), N / 8);
+        obitwrap8 obits8(ob8);
+        compare_write("obitwrap8", obits8, bits.get(), N, [&]() { ob8.pos(0); }, out_bytes.data(), bytes, N / 8);
+        std::vector<uint64_t> out_words(N / 64);
+        omstream<uint64_t> ob64(out_words.data(), N / 64);
+        obitwrap64 obits64(ob64);
+        compare_write("obitwrap64", obits64, bits.get(), N, [&]() { ob64.pos(0); }, out_words.data(), words.data(), N / 64);
+    }
+} test_io_bulk;
+
+class test_iwrapdecimate_t : public test_t {
+
+    const char *name() override { return "iwrapdecimate"; }
+
+    void test() override {
+        // 10 frames of 3 elements, every 4th frame passes: frames 0, 4, 8
+        const size_t F = 3, H = 4, N = 10 * F;
+        std::vector<int> x(N);
+        for (size_t i = 0; i < N; i++) x[i] = int(i);
+
+        imstream<int> in(x.data(), N);
+        iwrapdecimate<int> dec(in, F, H);
+        int y[9];
+        size_t n = dec.read(y, 4);
+        assert(n == 4 && dec.pos() == 4, "read %d, pos %d (4 expected)", int(n), int(dec.pos()));
+        n += dec.read(y + n, 5);
+        assert(n == 3 * F && dec.pos() == 3 * F, "read %d, pos %d at the end", int(n), int(dec.pos()));
+        for (size_t i = 0; i < n; i++) {
+            const int ref = int(i / F * H * F + i % F);
+            assert(y[i] == ref, "element %d: %d (%d expected)", int(i), y[i], ref);
+        }
+
+        // forward positioning in decimated elements
+        imstream<int> in2(x.data(), N);
+        iwrapdecimate<int> dec2(in2, F, H);
+        assert(dec2.pos(F + 1) == F + 1, "pos(%d): %d", int(F + 1), int(dec2.pos()));
+        int z = 0;
+        assert(dec2.get(z) && z == int(H * F + 1), "after pos(%d): %d", int(F + 1), z);
+    }
+} test_iwrapdecimate;
+
 NAMESPACE_TEST_END;
\ No newline at end of file
@@ -1,7 +1,13 @@
 #include "test.h"
 #include "../core/scale.h"
 #include "../core/mask.h"
+#include "../core/spectrum.h"
+#include "../core/simd.h"
 #include "../io/iobit.h"
+#include "../io/iomem.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 NAMESPACE_TEST_BEGIN;
 
@@ -110,4 +116,481 @@ test_mask_bit_naive("mask_bit_naive", true, false);
 //test_mask_bit_fast("mask_bit_fast", true, true);
 
 
+///
+/// Согласованность быстрой маскировки (через свертку) с прямым вычислением.
+/// Ошибка - доля отличающихся решений маскировки; 
+///  в сборке одинарной точности (SPL_FLOAT) часть решений вблизи порога 
+///  неизбежно меняется из-за шума FFT.
+///
+
+class test_mask_precision_t : public test_error_t
+{
+    const char *name() { return "mask_precision"; }
+    double max_error() { return sizeof(spectrum_t) < sizeof(double) ? 5E-3 : 1E-6; }
+    double error() {
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        const int K = sc.size();
+        const int L = 6000;
+        const freq_t F = 12000;
+        mask_params_t p = spl_params_t::DEFAULT.freq_mask;
+
+        // тон с шумом: без шума решения в каналах с почти нулевым спектром 
+        //  определяются погрешностью FFT, а не маскировкой
+        std::vector<signal_t> signal(L);
+        unsigned r = 1;
+        for (int i = 0; i < L; i++) {
+            double t = i / F;
+            r = r * 1103515245u + 12345u;
+            double noise = ((r >> 16) % 1000 / 1000.0 - 0.5) * 0.05;
+            signal[i] = signal_t(sin(2 * M_PI * (150 + 100 * t) * t) + 0.3 * sin(2 * M_PI * 1100 * t) + noise);
+        }
+        std::vector<spectrum_t> spec(L * K);
+        {
+            spectrum_calculator calc(sc, F, spl_params_t::DEFAULT.spectrum.ksi);
+            io::imstream<signal_t> in(signal.data(), L);
+            io::omstream<spectrum_t> out(spec.data(), spec.size());
+            calc.execute(in, out);
+        }
+
+        std::vector<unsigned char> m1(L * K), m2(L * K);
+        {
+            freq_mask_calculator calc(sc, p);
+            io::imstream<spectrum_t> in(spec.data(), spec.size());
+            io::omstream<mask_t> out((mask_t *)m1.data(), m1.size());
+            calc.execute(in, out);
+        }
+        {
+            freq_mask_calculator_fast calc(sc, p);
+            io::imstream<spectrum_t> in(spec.data(), spec.size());
+            io::omstream<mask_t> out((mask_t *)m2.data(), m2.size());
+            tic();
+            calc.execute(in, out);
+            set_execution_time(toc());
+        }
+
+        size_t diff = 0;
+        for (size_t i = 0; i < m1.size(); i++) {
+            diff += (m1[i] != 0) != (m2[i] != 0);
+        }
+        printf("mask precision (%s): %d of %d decisions differ\n", 
+            sizeof(spectrum_t) < sizeof(double) ? "float" : "double", int(diff), int(m1.size()));
+        return double(diff) / m1.size();
+    }
+} test_mask_precision;
+
+
+///
+/// Прямая маскировка на шкалах произвольной формы (мел, барк) - векторное ядро.
+/// Сравнивает каждый уровень SIMD со скалярным вариантом и печатает время,
+///  а также время быстрой маскировки на модельной шкале того же размера - для сравнения.
+///
+class test_mask_direct_t : public test_t
+{
+    const char *name() { return "mask_direct"; }
+    void test() {
+        const int K = 256, L = 4000;
+        mask_params_t p = spl_params_t::DEFAULT.freq_mask;
+        p.border_effect = false; // краевой эффект требует шкалы известной формы
+
+        std::vector<spectrum_t> spec(L * K);
+        unsigned r = 1;
+        for (size_t i = 0; i < spec.size(); i++) {
+            r = r * 1103515245u + 12345u;
+            spec[i] = spectrum_t((r >> 16) % 1000 / 1000.0 * (1 + sin(0.05 * (i % K))));
+        }
+
+        const scale_form_t forms[] = { scale_form_t::mel, scale_form_t::bark, scale_form_t::model };
+        const simd_level_t supported = simd_supported();
+        for (scale_form_t form: forms) {
+            freq_scale_t sc = freq_scale_t::generate(K, form, 50, 5000);
+            freq_mask_calculator calc(sc, p);
+
+            std::vector<unsigned char> ref(L * K), m(L * K);
+            printf("%s:", freq_scale_t::scale_form_name(form));
+            for (int level = simd_scalar; level <= supported; level++) {
+                simd_set_level(simd_level_t(level));
+                io::imstream<spectrum_t> in(spec.data(), spec.size());
+                io::omstream<mask_t> out((mask_t *)m.data(), m.size());
+                tic();
+                size_t written = calc.execute(in, out);
+                time_t t = toc();
+                printf(" %s %d ms", simd_level_name(simd_level_t(level)), int(t));
+                assert(written == m.size(), "written %d of %d", int(written), int(m.size()));
+
+                if (level == simd_scalar) {
+                    ref = m;
+                    continue;
+                }
+                // FMA округляет иначе - допускаются единичные расхождения на границе
+                size_t diff = 0;
+                for (size_t i = 0; i < m.size(); i++) {
+                    diff += (m[i] != 0) != (ref[i] != 0);
+                }
+                assert(diff <= m.size() / 10000, "%s: %d decisions differ from scalar", 
+                    simd_level_name(simd_level_t(level)), int(diff));
+            }
+            simd_set_level(supported);
+
+            if (form == scale_form_t::model) {
+                freq_mask_calculator_fast fast(sc, p);
+                io::imstream<spectrum_t> in(spec.data(), spec.size());
+                io::omstream<mask_t> out((mask_t *)m.data(), m.size());
+                tic();
+                fast.execute(in, out);
+                printf(" fast %d ms", int(toc()));
+            }
+            printf("\n");
+        }
+    }
+} test_mask_direct;
+
+
+///
+/// Маскировка по кадрам (модельная шкала): короткая прямая свертка с окном.
+/// Сравнивается с наивным вычислением; печатается время на кадр для нескольких допусков
+///  и для быстрого варианта, выдающего результат целыми блоками свертки.
+///
+class test_mask_frame_t : public test_t
+{
+    const char *name() { return "mask_frame"; }
+    void test() {
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        const int K = sc.size(), L = 4000;
+        mask_params_t p = spl_params_t::DEFAULT.freq_mask;
+
+        std::vector<spectrum_t> spec(L * K);
+        unsigned r = 1;
+        for (size_t i = 0; i < spec.size(); i++) {
+            r = r * 1103515245u + 12345u;
+            spec[i] = spectrum_t((r >> 16) % 1000 / 1000.0 * (1 + sin(0.05 * (i % K))));
+        }
+
+        std::vector<unsigned char> ref(L * K), m(L * K);
+        {
+            freq_mask_calculator calc(sc, p);
+            io::imstream<spectrum_t> in(spec.data(), spec.size());
+            io::omstream<mask_t> out((mask_t *)ref.data(), ref.size());
+            calc.execute(in, out);
+        }
+
+        // допуск по умолчанию (ksi) и более грубые
+        const double tolerances[] = { -1, 0.01, 0.1 };
+        for (double tol: tolerances) {
+            freq_mask_calculator_frame calc(sc, p, tol);
+            io::imstream<spectrum_t> in(spec.data(), spec.size());
+            io::omstream<mask_t> out((mask_t *)m.data(), m.size());
+            tic();
+            size_t written = calc.execute(in, out);
+            time_t t = toc();
+            assert(written == m.size(), "written %d of %d", int(written), int(m.size()));
+
+            size_t diff = 0;
+            for (size_t i = 0; i < m.size(); i++) {
+                diff += (m[i] != 0) != (ref[i] != 0);
+            }
+            printf("tolerance %lg: window %d, %.2f us per frame, %d of %d decisions differ\n", 
+                tol < 0 ? p.ksi : tol, calc.window_size(), 1000.0 * t / L, int(diff), int(m.size()));
+            // с допуском ksi окно не обрезается - отличия только от округления
+            if (tol < 0) {
+                assert(diff <= m.size() / 10000, "too many decisions differ: %d", int(diff));
+            }
+        }
+
+        freq_mask_calculator_fast fast(sc, p, CONV_SIZ_AUTO, spec.size());
+        io::imstream<spectrum_t> in(spec.data(), spec.size());
+        io::omstream<mask_t> out((mask_t *)m.data(), m.size());
+        tic();
+        fast.execute(in, out);
+        time_t t = toc();
+        // быстрый вариант выдает результат блоками свертки (около block_size / K кадров)
+        printf("fast: %.2f us per frame, block of %d values\n", 1000.0 * t / L, fast.block_size());
+    }
+} test_mask_frame;
+
+
+///
+/// Упакованная маска: выход каждого вычислителя в упакованном виде совпадает с выходом mask_t,
+///  биты после K нулевые; обертки потоков упаковывают и распаковывают без потерь.
+///
+class test_mask_packed_t : public test_t
+{
+    const char *name() { return "mask_packed"; }
+
+    /// Сравнение упакованного выхода \a words с выходом mask_t \a m.
+    void check(const char *what, int K, const std::vector<mask_word_t>& words, const std::vector<unsigned char>& m) {
+        const size_t W = mask_frame_words(K), L = m.size() / K;
+        std::vector<unsigned char> u(K);
+        size_t diff = 0, padding = 0;
+        for (size_t l = 0; l < L; l++) {
+            mask_unpack(K, &words[l * W], (mask_t *)u.data());
+            for (int k = 0; k < K; k++) {
+                diff += (u[k] != 0) != (m[l * K + k] != 0);
+            }
+            if (K % MASK_WORD_BITS) {
+                padding += (words[l * W + W - 1] >> (K % MASK_WORD_BITS)) != 0;
+            }
+        }
+        printf("%s: %d bytes packed, %d bytes mask_t\n", what, int(words.size() * sizeof(mask_word_t)), int(m.size() * sizeof(mask_t)));
+        assert(diff == 0, "%s: %d decisions differ", what, int(diff));
+        assert(padding == 0, "%s: %d frames with nonzero padding", what, int(padding));
+    }
+
+    void test() {
+        // K не кратно числу бит в слове - проверяется дополнение кадра
+        const int K = 250, L = 2000;
+        const size_t W = mask_frame_words(K);
+        freq_scale_t sc = freq_scale_t::generate(K, scale_form_t::model, 50, 5000);
+        mask_params_t p = spl_params_t::DEFAULT.freq_mask;
+
+        std::vector<spectrum_t> spec(L * K);
+        unsigned r = 1;
+        for (size_t i = 0; i < spec.size(); i++) {
+            r = r * 1103515245u + 12345u;
+            spec[i] = spectrum_t((r >> 16) % 1000 / 1000.0 * (1 + sin(0.05 * (i % K))));
+        }
+
+        std::vector<unsigned char> m(L * K);
+        std::vector<mask_word_t> words(L * W);
+
+        const simd_level_t supported = simd_supported();
+        for (int level = simd_scalar; level <= supported; level++) {
+            simd_set_level(simd_level_t(level));
+            freq_mask_calculator calc(sc, p);
+            io::imstream<spectrum_t> in1(spec.data(), spec.size()), in2(spec.data(), spec.size());
+            io::omstream<mask_t> out1((mask_t *)m.data(), m.size());
+            io::omstream<mask_word_t> out2(words.data(), words.size());
+            calc.execute(in1, out1);
+            assert(calc.execute(in2, out2) == words.size(), "naive: not all words written");
+            check(simd_level_name(simd_level_t(level)), K, words, m);
+        }
+        simd_set_level(supported);
+
+        {
+            freq_mask_calculator_frame calc(sc, p);
+            io::imstream<spectrum_t> in1(spec.data(), spec.size()), in2(spec.data(), spec.size());
+            io::omstream<mask_t> out1((mask_t *)m.data(), m.size());
+            io::omstream<mask_word_t> out2(words.data(), words.size());
+            calc.execute(in1, out1);
+            assert(calc.execute(in2, out2) == words.size(), "frame: not all words written");
+            check("frame", K, words, m);
+        }
+        {
+            freq_mask_calculator_fast calc(sc, p);
+            io::imstream<spectrum_t> in1(spec.data(), spec.size()), in2(spec.data(), spec.size());
+            io::omstream<mask_t> out1((mask_t *)m.data(), m.size());
+            io::omstream<mask_word_t> out2(words.data(), words.size());
+            calc.execute(in1, out1);
+            assert(calc.execute(in2, out2) == words.size(), "fast: not all words written");
+            check("fast", K, words, m);
+        }
+
+        // упаковка потока mask_t частями, не совпадающими с кадрами
+        std::vector<mask_word_t> words2(L * W);
+        io::imstream<mask_t> in((mask_t *)m.data(), m.size());
+        mask_pack_istream packed(in, K);
+        size_t read = 0;
+        for (size_t n = 1; read < words2.size(); n = n % 7 + 1) {
+            size_t got = packed.read(words2.data() + read, std::min(n, words2.size() - read));
+            if (got == 0) break;
+            read += got;
+        }
+        assert(read == words2.size() && packed.eos(), "packed read %d of %d words", int(read), int(words2.size()));
+        assert(words2 == words, "mask_pack_istream differs from the calculator output");
+
+        // mask_memory() дает одну и ту же маску независимо от типа выхода
+        assert(mask_memory(sc, L, spec.data(), (mask_t *)m.data(), p) == m.size(), "mask_memory: not all values written");
+        assert(mask_memory(sc, L, spec.data(), words.data(), p) == words.size(), "mask_memory: not all words written");
+        check("mask_memory", K, words, m);
+    }
+} test_mask_packed;
+
+
+///
+/// Прореживание во времени: выход с шагом hop совпадает с каждым hop-м кадром полного выхода.
+///
+class test_mask_hop_t : public test_t
+{
+    const char *name() { return "mask_hop"; }
+
+    /// Выход \a calc с шагом \a hop сравнивается с кадрами полного выхода \a full.
+    template<class calc_t>
+    void check(const char *what, calc_t& calc, int K, int hop,
+        const std::vector<spectrum_t>& spec, const std::vector<mask_word_t>& full)
+    {
+        const size_t W = mask_frame_words(K), L = spec.size() / K;
+        const size_t frames = (L + hop - 1) / hop;
+        std::vector<mask_word_t> words(frames * W);
+        calc.set_hop(hop);
+        io::imstream<spectrum_t> in(spec.data(), spec.size());
+        io::omstream<mask_word_t> out(words.data(), words.size());
+        size_t written = calc.execute(in, out);
+        calc.set_hop(1);
+        assert(written == words.size(), "%s: %d of %d words written", what, int(written), int(words.size()));
+        size_t diff = 0;
+        for (size_t i = 0; i < frames; i++) {
+            diff += !std::equal(&words[i * W], &words[i * W] + W, &full[i * hop * W]);
+        }
+        assert(diff == 0, "%s, hop %d: %d frames differ", what, hop, int(diff));
+    }
+
+    template<class calc_t>
+    void check_all(const char *what, calc_t& calc, int K, const std::vector<spectrum_t>& spec) {
+        std::vector<mask_word_t> full(spec.size() / K * mask_frame_words(K));
+        io::imstream<spectrum_t> in(spec.data(), spec.size());
+        io::omstream<mask_word_t> out(full.data(), full.size());
+        calc.execute(in, out);
+        for (int hop: { 2, 3, 10 }) {
+            check(what, calc, K, hop, spec, full);
+        }
+    }
+
+    void test() {
+        const int K = 250, L = 2001;
+        freq_scale_t sc = freq_scale_t::generate(K, scale_form_t::model, 50, 5000);
+        mask_params_t p = spl_params_t::DEFAULT.freq_mask;
+
+        std::vector<spectrum_t> spec(L * K);
+        unsigned r = 7;
+        for (size_t i = 0; i < spec.size(); i++) {
+            r = r * 1103515245u + 12345u;
+            spec[i] = spectrum_t((r >> 16) % 1000 / 1000.0 * (1 + sin(0.05 * (i % K))));
+        }
+
+        freq_mask_calculator naive(sc, p);
+        check_all("naive", naive, K, spec);
+        freq_mask_calculator_frame frame(sc, p);
+        check_all("frame", frame, K, spec);
+        freq_mask_calculator_fast fast(sc, p);
+        check_all("fast", fast, K, spec);
+    }
+} test_mask_hop;
+
+
+///
+/// Последовательная маскировка: совпадение векторных вариантов с прямой рекурсией,
+///  спад порога после маскера, совмещение с одновременной маскировкой (И двух масок).
+///
+class test_mask_temporal_t : public test_t
+{
+    const char *name() { return "mask_temporal"; }
+
+    template<class calc_t>
+    std::vector<mask_word_t> run(const calc_t& calc, int K, const std::vector<spectrum_t>& spec, int hop = 1) {
+        std::vector<mask_word_t> words((spec.size() / K + hop - 1) / hop * mask_frame_words(K));
+        io::imstream<spectrum_t> in(spec.data(), spec.size());
+        io::omstream<mask_word_t> out(words.data(), words.size());
+        size_t written = calc.execute(in, out);
+        assert(written == words.size(), "%d of %d words written", int(written), int(words.size()));
+        return words;
+    }
+
+    void test() {
+        const int K = 250, L = 3000;
+        const size_t W = mask_frame_words(K);
+        const freq_t F = 12000.0 / 60;
+        freq_scale_t sc = freq_scale_t::generate(K, scale_form_t::model, 50, 5000);
+        mask_params_t p = spl_params_t::DEFAULT.freq_mask;
+        temp_mask_params_t tp = spl_params_t::DEFAULT.temp_mask;
+
+        std::vector<spectrum_t> spec(L * K);
+        unsigned r = 11;
+        for (size_t i = 0; i < spec.size(); i++) {
+            r = r * 1103515245u + 12345u;
+            spec[i] = spectrum_t((r >> 16) % 1000 / 1000.0 * (1 + sin(0.05 * (i % K))) * (1 + sin(0.01 * (i / K))));
+        }
+
+        temp_mask_calculator temp(sc, F, tp);
+        const real_t a = temp.decay(), c = real_t(tp.rho) * a;
+
+        // прямая рекурсия
+        std::vector<mask_word_t> ref(L * W, 0);
+        std::vector<spectrum_t> E(K, 0);
+        for (int l = 0; l < L; l++) {
+            for (int k = 0; k < K; k++) {
+                const spectrum_t x = spec[l * K + k];
+                if (x > c * E[k])
+                    ref[l * W + k / MASK_WORD_BITS] |= mask_word_t(1) << (k % MASK_WORD_BITS);
+                E[k] = std::max(x, a * E[k]);
+            }
+        }
+
+        const simd_level_t supported = simd_supported();
+        for (int level = simd_scalar; level <= supported; level++) {
+            simd_set_level(simd_level_t(level));
+            tic();
+            std::vector<mask_word_t> words = run(temp, K, spec);
+            printf("%s: %.3f us per frame\n", simd_level_name(simd_level_t(level)), 1000.0 * toc() / L);
+            assert(words == ref, "%s: temporal mask differs from the recursion", simd_level_name(simd_level_t(level)));
+        }
+        simd_set_level(supported);
+
+        // маскер в кадре 0 скрывает более слабые кадры, пока порог не спадет ниже них
+        {
+            const int Li = 40;
+            std::vector<spectrum_t> impulse(Li * K, spectrum_t(1E-3));
+            std::fill_n(impulse.begin(), K, spectrum_t(1));
+            std::vector<mask_word_t> words = run(temp, K, impulse);
+            int first = -1;
+            for (int l = 1; l < Li && first < 0; l++) {
+                if (words[l * W] & 1) first = l;
+            }
+            const int expected = int(ceil(log(1E-3 / tp.rho) / log(double(a))));
+            printf("decay %.4f per frame: unmasked again after %d frames\n", double(a), first);
+            assert(words[0] & 1, "masker itself is masked");
+            assert(first == expected, "unmasked after %d frames instead of %d", first, expected);
+        }
+
+        // совмещение: И последовательной и одновременной маски
+        freq_mask_calculator naive(sc, p);
+        freq_mask_calculator_frame frame(sc, p);
+        freq_mask_calculator_fast fast(sc, p);
+        const io::filter<spectrum_t, mask_word_t> *freqs[] = { &naive, &frame, &fast };
+        const char *names[] = { "naive", "frame", "fast" };
+        for (int i = 0; i < 3; i++) {
+            std::vector<mask_word_t> fm = run(*freqs[i], K, spec);
+            for (size_t j = 0; j < fm.size(); j++) fm[j] &= ref[j];
+            temp_mask_calculator combined(sc, F, tp, freqs[i]);
+            assert(run(combined, K, spec) == fm, "%s: combined mask differs", names[i]);
+        }
+
+        // совмещение с прореживанием: порог - по всем кадрам, выход - каждый hop-й кадр
+        const int H = 3;
+        naive.set_hop(H);
+        frame.set_hop(H);
+        fast.set_hop(H);
+        temp.set_hop(H);
+        std::vector<mask_word_t> ref_hop = run(temp, K, spec, H);
+        assert(ref_hop.size() == (L + H - 1) / H * W, "hop %d: %d words", H, int(ref_hop.size()));
+        for (size_t j = 0; j < ref_hop.size(); j++) {
+            assert(ref_hop[j] == ref[j / W * H * W + j % W], "hop %d: word %d differs", H, int(j));
+        }
+        for (int i = 0; i < 3; i++) {
+            std::vector<mask_word_t> fm = run(*freqs[i], K, spec, H);
+            for (size_t j = 0; j < fm.size(); j++) fm[j] &= ref_hop[j];
+            temp_mask_calculator combined(sc, F, tp, freqs[i]);
+            combined.set_hop(H);
+            assert(run(combined, K, spec, H) == fm, "%s, hop %d: combined mask differs", names[i], H);
+
+        }
+
+        // шаги не совпадают: кадрам одновременной маски не хватает кадров последовательной
+        naive.set_hop(1);
+        frame.set_hop(1);
+        fast.set_hop(1);
+        for (int i = 0; i < 3; i++) {
+            temp_mask_calculator combined(sc, F, tp, freqs[i]);
+            combined.set_hop(H);
+            bool thrown = false;
+            try {
+                run(combined, K, spec);
+            }
+            catch (const char *) {
+                thrown = true;
+            }
+            assert(thrown, "%s: hop 1 with temporal hop %d is not an error", names[i], H);
+        }
+    }
+} test_mask_temporal;
+
+
 NAMESPACE_TEST_END;
\ No newline at end of file
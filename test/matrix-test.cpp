@@ -0,0 +1,102 @@
+﻿#include "test.h"
+#include "../core/spl_types.h"
+#include "../core/matrix.h"
+#include <cstdarg>
+#include <vector>
+
+NAMESPACE_TEST_BEGIN;
+
+using namespace spl;
+
+namespace {
+
+    /// Прежний способ обращения к матрице - через список аргументов переменной длины.
+    /// Оставлен для сравнения скорости.
+    size_t va_index(const size_t dims[], int D, size_t first, ...) {
+        size_t index = first;
+        va_list vl;
+        va_start(vl, first);
+        for (int d = 1; d < D; d++) {
+            index = index * dims[d] + va_arg(vl, size_t);
+        }
+        va_end(vl);
+        return index;
+    }
+
+}
+
+///
+/// Скорость обращения к элементам Matrix:
+///  транспонирование спектрограммы (K x Os) и заполнение таблиц разностей в стиле pitch_calculator.
+/// Сравнивается с прежним обращением через varargs и с ручной адресацией.
+///
+class test_matrix_access_t : public test_t
+{
+    const char *name() { return "matrix_access"; }
+    void test() {
+        const size_t K = 256, Os = 4096, R = 20;
+        std::vector<spectrum_t> a(K * Os), b(K * Os), c(K * Os);
+        for (size_t i = 0; i < a.size(); i++) {
+            a[i] = spectrum_t(i % 1000);
+        }
+        Matrix<spectrum_t, 2> m = matrix_ptr(&a[0], K, Os);
+        Matrix<spectrum_t, 2> t = matrix_ptr(&b[0], Os, K);
+
+        tic();
+        for (size_t r = 0; r < R; r++) {
+            transpose(m, t);
+        }
+        time_t t_matrix = toc();
+
+        tic();
+        for (size_t r = 0; r < R; r++) {
+            const size_t dims[] = { Os, K };
+            for (size_t i = 0; i < K; i++)
+                for (size_t j = 0; j < Os; j++)
+                    c[va_index(dims, 2, j, i)] = a[i * Os + j];
+        }
+        time_t t_va = toc();
+        assert(b == c, "transpose: results differ");
+
+        printf("transpose %dx%d: matrix %d ms, varargs %d ms\n", int(K), int(Os), int(t_matrix), int(t_va));
+
+        // таблицы разностей: части сэмпла x варианты части x шаблоны
+        const size_t P = 32, V = 256, T = 128;
+        std::vector<unsigned char> d1(P * V * T), d2(P * V * T), d3(P * V * T);
+        Matrix<unsigned char, 3> diff_tables = matrix_ptr(&d1[0], P, V, T);
+
+        tic();
+        for (size_t r = 0; r < R; r++)
+            for (int i = 0; i < int(P); i++)
+                for (int j = 0; j < int(V); j++)
+                    for (int k = 0; k < int(T); k++)
+                        diff_tables(i, j, k) = (unsigned char)((i + j * k) & 0xFF);
+        t_matrix = toc();
+
+        tic();
+        for (size_t r = 0; r < R; r++) {
+            const size_t dims[] = { P, V, T };
+            for (size_t i = 0; i < P; i++)
+                for (size_t j = 0; j < V; j++)
+                    for (size_t k = 0; k < T; k++)
+                        d2[va_index(dims, 3, i, j, k)] = (unsigned char)((i + j * k) & 0xFF);
+        }
+        t_va = toc();
+
+        tic();
+        for (size_t r = 0; r < R; r++)
+            for (size_t i = 0; i < P; i++)
+                for (size_t j = 0; j < V; j++) {
+                    unsigned char *row = &d3[(i * V + j) * T];
+                    for (size_t k = 0; k < T; k++)
+                        row[k] = (unsigned char)((i + j * k) & 0xFF);
+                }
+        const time_t t_ptr = toc();
+        assert(d1 == d2 && d1 == d3, "table fill: results differ");
+
+        printf("table fill %dx%dx%d: matrix %d ms, varargs %d ms, pointer %d ms\n", 
+            int(P), int(V), int(T), int(t_matrix), int(t_va), int(t_ptr));
+    }
+} test_matrix_access;
+
+NAMESPACE_TEST_END;
@@ -1,7 +1,12 @@
 #include "test.h"
 #include "../core/scale.h"
 #include "../core/spectrum.h"
+#include "../core/model.h"
 #include "../io/iowave.h"
+#include "../io/iomem.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 NAMESPACE_TEST_BEGIN;
 
@@ -67,4 +72,209 @@ class test_filter_wav_file_t : public test_error_t
     }
 } test_filter_wav_file;
 
-NAMESPACE_TEST_END;
\ No newline at end of file
+
+///
+/// Сравнение размеров окна свертки на сигналах разной длины.
+/// Печатает время вычисления спектра для каждого размера окна 
+///  и проверяет, что результат от размера окна не зависит.
+///
+
+class test_spectrum_block_size_t : public test_t
+{
+    const char *name() { return "spectrum_block_size"; }
+    void test() {
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        const int K = sc.size();
+        const size_t lengths[] = { 2000, 12000, 120000 };
+        const int sizes[] = { CONV_SIZ_AUTO, 1024, 2048, 4096, 8192, 16384, 32768 };
+
+        for (size_t L: lengths) {
+            std::vector<signal_t> signal(L);
+            for (size_t i = 0; i < L; i++) {
+                double t = i / sampling_freq_std;
+                signal[i] = sin(2 * M_PI * (150 + 100 * t) * t) + 0.3 * sin(2 * M_PI * 1100 * t);
+            }
+            std::vector<spectrum_t> ref, spec(L * K);
+
+            printf("length %6d:", int(L));
+            for (int N: sizes) {
+                int block;
+                time_t t;
+                try {
+                    spectrum_calculator calc(sc, sampling_freq_std, spectrum_ksi_std, N, L);
+                    block = calc.block_size();
+                    io::imstream<signal_t> in(signal.data(), L);
+                    io::omstream<spectrum_t> out(spec.data(), spec.size());
+                    tic();
+                    calc.execute(in, out);
+                    t = toc();
+                }
+                catch (const char *) {
+                    continue; // окно фильтров не помещается в блок
+                }
+                printf(N == CONV_SIZ_AUTO ? " [auto %d: %d ms]" : " %d: %d ms", block, int(t));
+
+                if (ref.empty()) {
+                    ref = spec;
+                    continue;
+                }
+                double e = 0;
+                for (size_t i = 0; i < spec.size(); i++) {
+                    e = std::max(e, std::abs(double(spec[i]) - double(ref[i])));
+                }
+                assert(e < 1E-10, "block size %d: spectrum differs by %lg", block, e);
+            }
+            printf("\n");
+        }
+    }
+} test_spectrum_block_size;
+
+
+///
+/// Повторное исполнение вычислителя: рабочая память создается в конструкторе,
+///  execute() ее не выделяет, а результат не зависит от предыдущего вызова.
+///
+
+class test_spectrum_workspace_t : public test_t
+{
+    const char *name() { return "spectrum_workspace"; }
+    void test() {
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        const int K = sc.size();
+        const size_t L = 20000;
+        std::vector<signal_t> signal(L);
+        for (size_t i = 0; i < L; i++) signal[i] = sin(0.05 * i) + 0.3 * sin(0.31 * i);
+        std::vector<spectrum_t> spec1(L * K), spec2(L * K);
+
+        spectrum_calculator calc(sc, sampling_freq_std, spectrum_ksi_std, 4096);
+        const size_t count = conv_alloc_count();
+        io::imstream<signal_t> in1(signal.data(), L), in2(signal.data(), L);
+        io::omstream<spectrum_t> out1(spec1.data(), spec1.size()), out2(spec2.data(), spec2.size());
+        calc.execute(in1, out1);
+        calc.execute(in2, out2);
+        assert(conv_alloc_count() == count, "execute allocated memory: %d times", int(conv_alloc_count() - count));
+        assert(spec1 == spec2, "second execute differs from the first one");
+    }
+} test_spectrum_workspace;
+
+///
+/// Точность вычисления спектра (в т.ч. в сборке одинарной точности SPL_FLOAT).
+/// Эталон - прямая свертка с теми же фильтрами в двойной точности.
+/// Ошибка - максимальное отклонение, отнесенное к максимальному значению спектра.
+///
+
+class test_spectrum_precision_t : public test_error_t
+{
+    const char *name() { return "spectrum_precision"; }
+    double max_error() { return sizeof(spectrum_t) < sizeof(double) ? 1E-5 : 1E-10; }
+    double error() {
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        const int K = sc.size();
+        const int L = 6000;
+        const freq_t F = sampling_freq_std;
+
+        std::vector<double> x(L);
+        std::vector<signal_t> signal(L);
+        for (int i = 0; i < L; i++) {
+            double t = i / F;
+            x[i] = sin(2 * M_PI * (150 + 100 * t) * t) + 0.3 * sin(2 * M_PI * 1100 * t);
+            signal[i] = signal_t(x[i]);
+        }
+
+        std::vector<spectrum_t> spec(L * K);
+        {
+            spectrum_calculator calc(sc, F, spectrum_ksi_std);
+            io::imstream<signal_t> in(signal.data(), L);
+            io::omstream<spectrum_t> out(spec.data(), spec.size());
+            tic();
+            calc.execute(in, out);
+            set_execution_time(toc());
+        }
+
+        // общий для всех каналов размер окна - как в spectrum_calculator
+        int Ws = 0;
+        for (int k = 0; k < K; k++) {
+            Ws = std::max(Ws, (int)model::gauss_border(model::filter_std(sc[k], F), spectrum_ksi_std));
+        }
+
+        // прямая свертка для каждого 8-го канала
+        double e = 0, m = 0;
+        for (int k = 0; k < K; k += 8) {
+            const double std = model::filter_std(sc[k], F);
+            const double Wf = 2 * M_PI * sc[k] / F;
+            for (int n = 0; n < L; n++) {
+                double re = 0, im = 0;
+                for (int j = -Ws; j <= Ws; j++) {
+                    if (n - j < 0 || n - j >= L) continue;
+                    double h = model::gauss_win<double>(j, 0.0, std);
+                    re += x[n - j] * h * cos(Wf * j);
+                    im += x[n - j] * h * sin(Wf * j);
+                }
+                double ref = re * re + im * im;
+                e = std::max(e, std::abs(double(spec[n * K + k]) - ref));
+                m = std::max(m, ref);
+            }
+        }
+
+        printf("spectrum precision (%s): max error %lg of %lg\n", 
+            sizeof(spectrum_t) < sizeof(double) ? "float" : "double", e, m);
+        return e / m;
+    }
+} test_spectrum_precision;
+
+///
+/// Прореженный выход: кадры с шагом hop совпадают с каждым hop-м кадром полного спектра.
+/// Малый шаг считается через FFT, большой - прямой сверткой (direct()).
+///
+
+class test_spectrum_hop_t : public test_error_t
+{
+    const char *name() { return "spectrum_hop"; }
+    double max_error() { return sizeof(spectrum_t) < sizeof(double) ? 1E-5 : 1E-10; }
+    double error() {
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        const int K = sc.size();
+        const size_t L = 24000;
+        const freq_t F = sampling_freq_std;
+
+        std::vector<signal_t> signal(L);
+        for (size_t i = 0; i < L; i++) {
+            double t = i / F;
+            signal[i] = sin(2 * M_PI * (150 + 100 * t) * t) + 0.3 * sin(2 * M_PI * 1100 * t);
+        }
+
+        std::vector<spectrum_t> ref(L * K);
+        {
+            spectrum_calculator calc(sc, F, spectrum_ksi_std, CONV_SIZ_AUTO, L);
+            io::imstream<signal_t> in(signal.data(), L);
+            io::omstream<spectrum_t> out(ref.data(), ref.size());
+            tic();
+            calc.execute(in, out);
+            printf("hop %3d: %d ms\n", 1, int(toc()));
+        }
+        const double m = *std::max_element(ref.begin(), ref.end());
+
+        double e = 0;
+        const int hops[] = { 4, 60, 160 };
+        for (int hop: hops) {
+            const size_t frames = (L + hop - 1) / hop;
+            std::vector<spectrum_t> spec(frames * K + K);
+            spectrum_calculator calc(sc, F, spectrum_ksi_std, CONV_SIZ_AUTO, L, hop);
+            io::imstream<signal_t> in(signal.data(), L);
+            io::omstream<spectrum_t> out(spec.data(), spec.size());
+            tic();
+            size_t written = calc.execute(in, out);
+            printf("hop %3d (%s): %d ms\n", hop, calc.direct() ? "direct" : "fft", int(toc()));
+
+            assert(written == frames * K, "hop %d: %d frames instead of %d", hop, int(written / K), int(frames));
+            for (size_t i = 0; i < frames; i++) {
+                for (int k = 0; k < K; k++) {
+                    e = std::max(e, std::abs(double(spec[i * K + k]) - double(ref[i * hop * K + k])) / m);
+                }
+            }
+        }
+        return e;
+    }
+} test_spectrum_hop;
+
+NAMESPACE_TEST_END;
@@ -1,7 +1,13 @@
 ﻿#include "test.h"
 #include "../core/scale.h"
 #include "../core/vocal.h"
+#include "../core/bits.h"
+#include "../core/spectrum.h"
+#include "../core/simd.h"
+#include <queue>
+#include <vector>
 #include "../io/iofile.h"
+#include "../io/iomem.h"
 
 NAMESPACE_TEST_BEGIN;
 
@@ -126,4 +132,391 @@ class test_vocal_segment_t : public test_error_t
     }
 } test_vocal_segment;
 
+namespace {
+
+    /// Упакованная маска синтетического сигнала из \a N отсчетов (частота дискретизации 12 кГц):
+    ///  четыре гармоники с ЧОТ, плавно растущей от 120 Гц, и участок шума в середине.
+    std::vector<mask_word_t> synth_mask(const freq_scale_t& sc, int N) {
+        const freq_t F = 12000;
+        std::vector<signal_t> s(N);
+        unsigned r = 1;
+        for (int i = 0; i < N; i++) {
+            const double t = i / F, f0 = 120 + 80 * t;
+            double v = 0;
+            for (int h = 1; h <= 4; h++) {
+                v += sin(2 * M_PI * h * f0 * t) / h;
+            }
+            r = r * 1103515245u + 12345u;
+            const double noise = (r >> 16) % 1000 / 1000.0 - 0.5;
+            s[i] = signal_t(i > N / 2 && i < N / 2 + 3000 ? noise : v + 0.05 * noise);
+        }
+
+        const int K = sc.size();
+        std::vector<spectrum_t> spec(size_t(N) * K);
+        std::vector<mask_word_t> mask(N * mask_frame_words(K));
+        {
+            spectrum_calculator calc(sc, F, spl_params_t::DEFAULT.spectrum.ksi);
+            imstream<signal_t> in(s.data(), s.size());
+            omstream<spectrum_t> out(spec.data(), spec.size());
+            calc.execute(in, out);
+        }
+        {
+            freq_mask_calculator calc(sc, spl_params_t::DEFAULT.freq_mask);
+            imstream<spectrum_t> in(spec.data(), spec.size());
+            omstream<mask_word_t> out(mask.data(), mask.size());
+            calc.execute(in, out);
+        }
+        return mask;
+    }
+
+}
+
+///
+/// Способы сравнения с шаблонами ЧОТ: табличный и подсчет бит (на каждом уровне SIMD).
+/// Маска - от синтетического сигнала с плавно меняющейся ЧОТ и участком шума;
+///  результаты должны совпадать, печатается количество кадров в секунду.
+///
+class test_pitch_matcher_t : public test_t
+{
+    const char *name() { return "pitch_matcher"; }
+    void test() {
+        const int N = 24000, R = 20;
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        std::vector<mask_word_t> mask = synth_mask(sc, N);
+
+        pitch_calculator calc(sc, spl_params_t::DEFAULT.freq_mask, spl_params_t::DEFAULT.pitch);
+        std::vector<short> ref(N), p(N);
+
+        const simd_level_t supported = simd_supported();
+        const pitch_matcher_t matchers[] = { pitch_matcher_t::table, pitch_matcher_t::popcount };
+        for (pitch_matcher_t matcher: matchers) {
+            calc.set_matcher(matcher);
+            for (int level = simd_scalar; level <= supported; level++) {
+                simd_set_level(simd_level_t(level));
+                if (matcher == pitch_matcher_t::table && level > simd_scalar) break;
+
+                tic();
+                for (int i = 0; i < R; i++) {
+                    imstream<mask_word_t> in(mask.data(), mask.size());
+                    omstream<short> out(p.data(), p.size());
+                    calc.execute(in, out);
+                }
+                const time_t t = toc();
+                printf("%s %s: %.0f frames/s\n", matcher == pitch_matcher_t::table ? "table" : "popcount",
+                    matcher == pitch_matcher_t::table ? "" : simd_level_name(simd_level_t(level)), 
+                    1000.0 * N * R / std::max<time_t>(t, 1));
+
+                if (matcher == pitch_matcher_t::table) {
+                    ref = p;
+                    continue;
+                }
+                size_t diff = 0;
+                for (int i = 0; i < N; i++) {
+                    diff += p[i] != ref[i];
+                }
+                assert(diff == 0, "%d frames differ from the table matcher", int(diff));
+            }
+            simd_set_level(supported);
+        }
+
+        size_t voiced = 0;
+        for (int i = 0; i < N; i++) {
+            voiced += ref[i] >= 0;
+        }
+        assert(voiced > size_t(N / 2), "only %d voiced frames of %d", int(voiced), N);
+    }
+} test_pitch_matcher;
+
+///
+/// Счетчики в байтах (bits.h): побайтовое сложение и вычитание без переносов между байтами
+///  и подсчет бит сравниваются с поэлементным вычислением.
+///
+class test_bits_t : public test_t
+{
+    const char *name() { return "bits"; }
+    void test() {
+        unsigned long long r = 1;
+        auto next = [&r]() { r = r * 6364136223846793005ULL + 1442695040888963407ULL; return mask_word_t(r); };
+
+        size_t errors = 0;
+        for (int i = 0; i < 100000; i++) {
+            const mask_word_t a = next(), b = next();
+            const mask_word_t s = bytes_add(a, b), d = bytes_sub(a, b);
+            unsigned bits = 0;
+            for (int j = 0; j < 64; j++) {
+                bits += (a >> j) & 1;
+            }
+            for (int j = 0; j < 64; j += 8) {
+                const unsigned x = (a >> j) & 0xFF, y = (b >> j) & 0xFF;
+                errors += ((s >> j) & 0xFF) != ((x + y) & 0xFF);
+                errors += ((d >> j) & 0xFF) != ((x - y) & 0xFF);
+            }
+            errors += popcount_word(a) != bits;
+            errors += popcount_swar(a) != bits;
+        }
+        assert(errors == 0, "%d errors", int(errors));
+    }
+} test_bits;
+
+///
+/// Кандидаты ЧОТ: первый кандидат совпадает с основным выходом,
+///  отличия не убывают, уверенность от 0 до 1.
+///
+class test_pitch_candidates_t : public test_t
+{
+    const char *name() { return "pitch_candidates"; }
+    void test() {
+        const int N = 12000, C = 4;
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        std::vector<mask_word_t> mask = synth_mask(sc, N);
+
+        pitch_calculator calc(sc, spl_params_t::DEFAULT.freq_mask, spl_params_t::DEFAULT.pitch);
+        calc.set_candidates(0);
+        assert(calc.candidates() == 1, "set_candidates(0): %d candidates", calc.candidates());
+        calc.set_candidates(100000);
+        assert(calc.candidates() == calc.templates(), "set_candidates(%d): %d candidates of %d templates",
+            100000, calc.candidates(), calc.templates());
+        calc.set_candidates(C);
+        std::vector<short> p(N);
+        std::vector<pitch_candidate_t> c(N * C);
+        for (pitch_matcher_t m: { pitch_matcher_t::table, pitch_matcher_t::popcount }) {
+            calc.set_matcher(m);
+            imstream<mask_word_t> in(mask.data(), mask.size());
+            omstream<short> out(p.data(), p.size());
+            const size_t n = calc.execute(in, out);
+            assert(n == size_t(N), "pitch: %d frames of %d", int(n), N);
+        }
+        size_t frames;
+        {
+            imstream<mask_word_t> in(mask.data(), mask.size());
+            omstream<pitch_candidate_t> out(c.data(), c.size());
+            tic();
+            frames = calc.execute(in, out);
+            set_execution_time(toc());
+        }
+        assert(frames == size_t(N), "%d frames of %d", int(frames), N);
+
+        for (int i = 0; i < N; i++) {
+            const pitch_candidate_t *f = &c[i * C];
+            const short best = f[0].distance < DEFAULT_PITCH_MAX_DIFF ? f[0].channel : -1;
+            assert(best == p[i], "frame %d: candidate %d, pitch %d", i, int(best), int(p[i]));
+            for (int n = 0; n < C; n++) {
+                assert(f[n].confidence >= 0 && f[n].confidence <= 1, "frame %d: confidence %g", i, f[n].confidence);
+                assert(n == 0 || f[n].distance >= f[n-1].distance, "frame %d: distances not sorted", i);
+            }
+        }
+    }
+} test_pitch_candidates;
+
+///
+/// Сопровождение ЧОТ (pitch_tracker): при нулевых стоимостях переходов совпадает с выделением
+///  по кадрам, со стандартными параметрами - печатается количество скачков ЧОТ
+///  (больше чем на 3 канала между соседними вокализованными кадрами).
+///
+class test_pitch_tracker_t : public test_t
+{
+    const char *name() { return "pitch_tracker"; }
+
+    static size_t jumps(const std::vector<short>& p) {
+        size_t n = 0;
+        for (size_t i = 1; i < p.size(); i++) {
+            n += p[i] >= 0 && p[i-1] >= 0 && abs(p[i] - p[i-1]) > 3;
+        }
+        return n;
+    }
+
+    void test() {
+        const int N = 24000;
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        std::vector<mask_word_t> mask = synth_mask(sc, N);
+
+        pitch_calculator calc(sc, spl_params_t::DEFAULT.freq_mask, spl_params_t::DEFAULT.pitch);
+        std::vector<short> ref(N);
+        {
+            imstream<mask_word_t> in(mask.data(), mask.size());
+            omstream<short> out(ref.data(), ref.size());
+            calc.execute(in, out);
+        }
+
+        // полный вектор отличий
+        const int C = calc.templates();
+        calc.set_candidates(C);
+        std::vector<pitch_candidate_t> c(size_t(N) * C);
+        {
+            imstream<mask_word_t> in(mask.data(), mask.size());
+            omstream<pitch_candidate_t> out(c.data(), c.size());
+            calc.execute(in, out);
+        }
+
+        pitch_track_params_t free = { 16, 0, 0, 0 };
+        const pitch_track_params_t params[] = { free, pitch_track_params_t::DEFAULT };
+        for (const pitch_track_params_t& p: params) {
+            pitch_tracker tracker(calc, p);
+            std::vector<short> tr(N, -2);
+            imstream<pitch_candidate_t> in(c.data(), c.size());
+            omstream<short> out(tr.data(), tr.size());
+            tic();
+            size_t frames = tracker.execute(in, out);
+            time_t t = toc();
+            assert(frames == size_t(N) && out.pos() == size_t(N), "%d frames, %d written", int(frames), int(out.pos()));
+
+            size_t diff = 0, voiced = 0;
+            for (int i = 0; i < N; i++) {
+                diff += tr[i] != ref[i];
+                voiced += tr[i] >= 0;
+            }
+            printf("lag %d, step %d, jump %d, voicing %d: %.0f frames/s, %d voiced, %d jumps (frame decisions: %d), %d frames differ\n",
+                p.lag, p.step_cost, p.jump_cost, p.voicing_cost, 1000.0 * N / std::max<time_t>(t, 1),
+                int(voiced), int(jumps(tr)), int(jumps(ref)), int(diff));
+            if (p.step_cost == 0 && p.jump_cost == 0 && p.voicing_cost == 0) {
+                assert(diff == 0, "free transitions: %d frames differ", int(diff));
+            } else {
+                assert(jumps(tr) <= jumps(ref), "tracking added jumps");
+            }
+        }
+    }
+} test_pitch_tracker;
+
+namespace {
+
+    /// Прежняя реализация vocal_segment (очередь std::queue, вывод по одному значению).
+    /// Оставлена для сравнения результатов и скорости.
+    size_t vocal_segment_queue(istream<short>& in_str, ostream<short>& out_str, freq_t F, const vocal_params_t& p) {
+        int minV = int(p.minV * F), minNV = int(p.minNV * F);
+        bool VocP = false, Voc;
+        short kffp = 0, kff;
+        int Tnv = 0, Tkv = 0, T = 0;
+        size_t written = 0;
+        std::queue<short> q;
+        enum { out_v, out_nv, keep } action = keep;
+
+        while (in_str.get(kff)) {
+            kff = kff + 1;
+            Voc = kff != 0;
+            if (VocP && Voc) {
+                if (kff - kffp < 2 && kffp - kff < 2) {
+                    if (T - Tnv == minV && Tnv - Tkv > minNV) action = out_v;
+                } else {
+                    Voc = false;
+                }
+            }
+            if (!VocP && Voc) { Tnv = T; action = keep; }
+            if (VocP && !Voc) {
+                if (T - Tnv > minV) { Tkv = T; action = keep; }
+                else if (T - Tkv > minNV) { if (Tnv - Tkv <= minNV) action = out_nv; }
+            }
+            if (!VocP && !Voc) {
+                if (T - Tkv == minNV) action = out_nv;
+            }
+            switch (action) {
+            case out_v:
+                while (!q.empty()) { if (out_str.put(q.front() - 1)) written++; q.pop(); }
+                if (out_str.put(kff - 1)) written++;
+                break;
+            case out_nv:
+                while (!q.empty()) { if (out_str.put(-1)) written++; q.pop(); }
+                if (out_str.put(-1)) written++;
+                break;
+            case keep:
+                q.push(kff);
+                break;
+            }
+            VocP = Voc;
+            kffp = kff;
+            T++;
+        }
+        return written;
+    }
+
+}
+
+///
+/// Сегментация по вокализованности (vocal_calculator): совпадение с прежней реализацией
+///  на случайных последовательностях сегментов (в т.ч. длинных вокализованных участках),
+///  совпадение совмещенного с ЧОТ варианта с последовательным вычислением.
+///
+class test_vocal_calculator_t : public test_t
+{
+    const char *name() { return "vocal_calculator"; }
+
+    void test() {
+        const freq_t F = 1000;
+        const size_t N = 400000;
+
+        // сегменты случайной длины: невокализованные, вокализованные с плавной ЧОТ и скачками
+        std::vector<short> pitch(N);
+        unsigned r = 3;
+        for (size_t i = 0; i < N; ) {
+            r = r * 1103515245u + 12345u;
+            const int kind = (r >> 16) % 4;
+            r = r * 1103515245u + 12345u;
+            size_t len = 1 + (r >> 16) % (kind == 3 ? 5000 : 80);
+            short k = short(20 + (r >> 8) % 100);
+            for (; len > 0 && i < N; len--, i++) {
+                r = r * 1103515245u + 12345u;
+                if (kind == 0) pitch[i] = -1;
+                else {
+                    k = short(std::max(0, k + int((r >> 16) % (kind == 1 ? 7 : 3)) - (kind == 1 ? 3 : 1)));
+                    pitch[i] = k;
+                }
+            }
+        }
+
+        const vocal_params_t params[] = { vocal_params_t::DEFAULT, { 0.005, 0.010 }, { 0.050, 0.002 } };
+        for (const vocal_params_t& p: params) {
+            std::vector<short> ref(N, -2), v(N, -2);
+            size_t n_ref, n;
+            time_t t_ref, t;
+            {
+                imstream<short> in(pitch.data(), N);
+                omstream<short> out(ref.data(), N);
+                tic();
+                n_ref = vocal_segment_queue(in, out, F, p);
+                t_ref = toc();
+            }
+            {
+                vocal_calculator calc(F, p);
+                imstream<short> in(pitch.data(), N);
+                omstream<short> out(v.data(), N);
+                tic();
+                n = calc.execute(in, out);
+                t = toc();
+            }
+            printf("minV %g, minNV %g: %d of %d frames decided, queue %d ms, ring %d ms\n",
+                p.minV, p.minNV, int(n), int(N), int(t_ref), int(t));
+            assert(n == n_ref, "%d values written instead of %d", int(n), int(n_ref));
+            assert(v == ref, "segmentation differs from the previous implementation");
+        }
+
+        // ЧОТ и сегментация в одном потоке
+        const int Nm = 24000;
+        freq_scale_t sc = freq_scale_t::generate(spl_params_t::DEFAULT.scale);
+        std::vector<mask_word_t> mask = synth_mask(sc, Nm);
+        pitch_calculator calc(sc, spl_params_t::DEFAULT.freq_mask, spl_params_t::DEFAULT.pitch);
+        const freq_t Fs = 12000;
+
+        std::vector<short> p(Nm), ref(Nm, -2), fused(Nm, -2);
+        {
+            imstream<mask_word_t> in(mask.data(), mask.size());
+            omstream<short> out(p.data(), p.size());
+            calc.execute(in, out);
+        }
+        size_t n_ref;
+        {
+            vocal_calculator vocal(Fs, vocal_params_t::DEFAULT);
+            imstream<short> in(p.data(), p.size());
+            omstream<short> out(ref.data(), ref.size());
+            n_ref = vocal.execute(in, out);
+        }
+        {
+            vocal_calculator vocal(Fs, vocal_params_t::DEFAULT, &calc);
+            imstream<mask_word_t> in(mask.data(), mask.size());
+            omstream<short> out(fused.data(), fused.size());
+            size_t n = vocal.execute(in, out);
+            assert(n == n_ref, "fused: %d values written instead of %d", int(n), int(n_ref));
+        }
+        assert(fused == ref, "fused segmentation differs");
+    }
+} test_vocal_calculator;
+
 NAMESPACE_TEST_END;
\ No newline at end of file